@@ -18,111 +18,54 @@
 #include "adinvariantobstruction.h"
 
 
-template<typename Iterator, typename Iterator2>
-list<set<typename Iterator::value_type>> subsets_of(Iterator begin, Iterator2 end) {
-	list<set<typename Iterator::value_type>> result;
-	if (begin==end) return {{}};
-	else {
-		auto first=*begin;
-		list<set<typename Iterator::value_type>> without_first=subsets_of(++begin,end);
-		list<set<typename Iterator::value_type>> with_first;
-		for (auto x: without_first) {
-			x.insert(first);
-			with_first.push_back(x);
-		}
-		without_first.splice(without_first.end(),with_first);
-		return without_first;
-	}
-}
-
-//a subspace of a nice Lie algebra spanned by nice basis elements
-class NiceSubspace {
-	set<int> generators;
+//subspaces of a nice Lie algebra spanned by nice basis elements, represented as bitmasks of nodes
+class NiceSubspaces {
+	int nodes;
+	uint64_t all_nodes;
+	vector<uint64_t> reached, brackets;	//for each node, the nodes it is joined to by an outgoing arrow and the labels of these arrows
+	static int dimension(uint64_t V) {return __builtin_popcountll(V);}
 public:
-	template<typename T>	NiceSubspace(T&& generators) : generators{std::forward<T>(generators)} {}
-	NiceSubspace(int n) : generators{consecutive_numbers(0,n)} {}
-	NiceSubspace() =default;	
-	static list<NiceSubspace> all_subspaces(const SetOfNodes& diagram) {
-		vector<int> all_nodes(diagram.number_of_nodes());
-		iota(all_nodes.begin(),all_nodes.end(),0);
-		list<NiceSubspace> result;
-		for (auto generators :  subsets_of(all_nodes.begin(),all_nodes.end())) result.push_back(generators);
-		return result;
+	NiceSubspaces(const LabeledTree& diagram) : nodes{diagram.number_of_nodes()}, reached(nodes), brackets(nodes) {
+		assert(nodes<64);
+		all_nodes=(uint64_t{1}<<nodes)-1;
+		for (int i=0;i<nodes;++i) reached[i]=diagram.outgoing_nodes(i);
+		for (auto& arrow: diagram.arrows())
+			if (arrow.has_label()) brackets[arrow.node_in]|=uint64_t{1}<<arrow.label;
 	}
-	
-	int dimension() const {return generators.size();}
-
-	NiceSubspace reached_from(const LabeledTree& diagram) const {
-		NiceSubspace result;
-	  for (auto& arrow: diagram.arrows()) 
-      if (generators.find(arrow.node_in)!=generators.end()) result.generators.insert(arrow.node_out);
+	uint64_t reached_from(uint64_t V) const {
+		uint64_t result=0;
+		for (;V;V&=V-1) result|=reached[__builtin_ctzll(V)];
 		return result;
 	}
-
-	NiceSubspace commuting_with(const LabeledTree& diagram) const {
-		NiceSubspace result{diagram.number_of_nodes()};	
-	  for (auto& arrow: diagram.arrows()) 
-      if (generators.find(arrow.node_in)!=generators.end()) {result.generators.erase(arrow.label);}
-		return result;
+	uint64_t commuting_with(uint64_t V) const {
+		uint64_t result=0;
+		for (;V;V&=V-1) result|=brackets[__builtin_ctzll(V)];
+		return all_nodes & ~result;
 	}
-	
-	NiceSubspace ending_in(const LabeledTree& diagram) const {
-		NiceSubspace result{diagram.number_of_nodes()};	
-	  for (auto& arrow: diagram.arrows()) 
-      if (generators.find(arrow.node_out)==generators.end()) {result.generators.erase(arrow.node_in);}
-    return result;
-   }
-   
-   string to_string() const {return horizontal(generators," ");}
-};
-
-vector<int> generalized_lcs(const LabeledTree& diagram, NiceSubspace V) {
-	vector<int> result;
-	result.push_back(V.dimension());	
-	while (V.dimension()>0) {
-		V=V.reached_from(diagram);
-		result.push_back(V.dimension());	
-	}	
-	return result;
-}
-
-vector<int> generalized_ucs(const LabeledTree& diagram, NiceSubspace V) {
-	vector<int> result;
-	NiceSubspace C_kV=V.commuting_with(diagram);
-	result.push_back(0);
-	result.push_back(C_kV.dimension());
-	while (C_kV.dimension()!=diagram.number_of_nodes()) {
-		C_kV=C_kV.ending_in(diagram);
-		result.push_back(C_kV.dimension());	
+	uint64_t ending_in(uint64_t V) const {
+		uint64_t result=0;
+		for (int i=0;i<nodes;++i)
+			if (!(reached[i] & ~V)) result|=uint64_t{1}<<i;
+		return result;
 	}
-	return result;
-}
-
-int element_at_or_last_element_in(const vector<int>& v, int index) {
-	return index<v.size()? v[index] : v.back();
-}
-
-bool passes_obstruction_for_ad_invariant_metric(const LabeledTree& diagram, const NiceSubspace& V) {
-	auto lcs=	generalized_lcs(diagram,V);
-	auto ucs= generalized_ucs(diagram,V);	
-	int i=1;
-	while (i<lcs.size() || i<ucs.size()) {
-		auto l=	element_at_or_last_element_in(lcs,i);
-		auto u=	element_at_or_last_element_in(ucs,i);		
-		if (l+u!=diagram.number_of_nodes()) {
-//				cout<<"Diagram "<<diagram.as_string()<<", obsturction failed for "<<V.to_string()<<endl;		
-//				cout<<lcs<<endl<<ucs<<endl;
-			return false;
+	//compare the generalized lower and upper central series of V, extending the shorter one by its last element
+	bool passes_obstruction(uint64_t V) const {
+		auto lower=reached_from(V), upper=commuting_with(V);
+		if (dimension(lower)+dimension(upper)!=nodes) return false;
+		while (lower || upper!=all_nodes) {
+			lower=reached_from(lower);
+			upper=ending_in(upper);
+			if (dimension(lower)+dimension(upper)!=nodes) return false;
 		}
-		++i;
+		return true;
 	}
-//	cout<<"Diagram "<<diagram.as_string()<<", obsturction passed for "<<V.to_string()<<endl;
-	return true;
-}
-
+	bool passes_obstruction_for_all_subspaces() const {
+		for (uint64_t V=0;V<=all_nodes;++V)
+			if (!passes_obstruction(V)) return false;
+		return true;
+	}
+};
 
 bool passes_obstruction_for_ad_invariant_metric(const LabeledTree& diagram) {
-	auto all=NiceSubspace::all_subspaces(diagram);
-	return all_of(all.begin(),all.end(),[&diagram] (const NiceSubspace& V) {return passes_obstruction_for_ad_invariant_metric(diagram,V);});
+	return NiceSubspaces{diagram}.passes_obstruction_for_all_subspaces();
 }
-
@@ -43,6 +43,7 @@ struct LabeledArrow {
 	}
 	bool operator==(const LabeledArrow& other) const {return node_in==other.node_in && node_out==other.node_out && label==other.label;}
 	bool has_label() const {return label!=NO_LABEL;}
+	void remove_label() {label=NO_LABEL;}
 	void invert(int number_of_nodes) {
 	  node_in=number_of_nodes-node_in-1; node_out=number_of_nodes-node_out-1;
 	  if (has_label()) label=  number_of_nodes-label-1;
@@ -65,6 +66,10 @@ struct LabeledDoubleArrow {
 	bool has_label() const {return label!=pair<int,int>{};}
 };
 
+//the label of an arrow, or -1 if the arrow has no label
+inline int label_of(const Arrow&) {return -1;}
+inline int label_of(const LabeledArrow& arrow) {return arrow.has_label()? arrow.label : -1;}
+
 ostream& operator<<(ostream& os, Arrow arrow);
 ostream& operator<<(ostream& os, LabeledArrow arrow);
 ostream& operator<<(ostream& os, LabeledDoubleArrow arrow);
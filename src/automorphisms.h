@@ -7,7 +7,7 @@ class PartialAutomorphism {
 public:
 	enum class AssignResult {NOCHANGE, CHANGED, INCOMPATIBLE};	
 
-	PartialAutomorphism(const vector<int>& hash_codes ) : images(hash_codes.size(),UNASSIGNED), hash_codes_of_unassigned{hash_codes} {
+	PartialAutomorphism(const vector<int>& hash_codes ) : images(hash_codes.size(),UNASSIGNED), hash_codes{hash_codes}, hash_codes_of_unassigned{hash_codes} {
 		for (auto& code : hash_codes_of_unassigned)
 			if (code==IN_IMAGE) code=-2;	//IN_IMAGE value is reserved, so replace occurrences of IN_IMAGE with a different value.
 	}
@@ -20,8 +20,8 @@ public:
 		list<vector<int>> result;
 		int i=first_unassigned();
 		for (int j=0;j<images.size();++j) 
-			if (hash_codes_of_unassigned[j]==tree.node_hash()[i]) {
-				auto enlarged=with_assignment(tree.arrows(), i,j);
+			if (hash_codes_of_unassigned[j]==hash_codes[i]) {
+				auto enlarged=with_assignment(tree, i,j);
 				if (enlarged) result.splice(result.end(),enlarged.value().enlargements(tree));
 			}
 		return result;
@@ -31,6 +31,7 @@ private:
 	static constexpr int UNASSIGNED=-1;
 	static constexpr int IN_IMAGE=-1;
 	vector<int> images;											//i-th element is either sigma_i or UNASSIGNED
+	vector<int> hash_codes;
 	vector<int> hash_codes_of_unassigned;		//i-th  element is either the hash chode of i-th node or IN_IMAGE if i=image[j] for some j
 	
 	AssignResult assign(int i, int sigma_i) {
@@ -44,14 +45,15 @@ private:
 	}
 	
 //TODO for unlabeled arrows, the logic should be that assignments are made when only one choice is possible
-	AssignResult match_arrow(LabeledArrow arrow,const list<LabeledArrow>& arrows);
+	AssignResult match_arrow(LabeledArrow arrow,const TreeBase<LabeledArrow>& tree);
 
 	template<typename ArrowType>
-	optional<PartialAutomorphism> with_assignment(const list<ArrowType>& arrows,int i, int sigma_i) const {
+	optional<PartialAutomorphism> with_assignment(const TreeBase<ArrowType>& tree,int i, int sigma_i) const {
 		PartialAutomorphism result=*this;
 		result.assign(i,sigma_i);
+		auto& arrows=tree.arrows();
 	 	for (auto i=arrows.begin();i!=arrows.end();) {
-	 		switch (result.match_arrow(*i,arrows)) {
+	 		switch (result.match_arrow(*i,tree)) {
 	 			case AssignResult::CHANGED : i=arrows.begin(); break;
 	 			case AssignResult::INCOMPATIBLE: return nullopt;
 	 			case AssignResult::NOCHANGE : ++i;
@@ -72,7 +74,7 @@ private:
 
 template<typename Arrow>
 list<vector<int>> automorphisms(const TreeBase<Arrow>& tree) {
-	PartialAutomorphism partial{tree.node_hash()};
+	PartialAutomorphism partial{tree.node_classes()};
 	return partial.enlargements(tree);
 }
 
@@ -0,0 +1,187 @@
+/*  Copyright (C) 2018-2023 by Diego Conti, diego.conti@unipi.it
+
+    This file is part of DEMONbLAST
+
+    DEMONbLAST is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DEMONbLAST is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DEMONbLAST.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CANONICAL_FORM_H
+#define CANONICAL_FORM_H
+
+#include "arrow.h"
+#include <array>
+
+namespace canonical_form_impl {
+	const int NO_LABEL=-1;
+
+	using Relation = std::array<int,3>;	//node_in, node_out, label
+
+/* Canonical labeling by individualization and refinement, in the spirit of nauty.
+  The nodes are colored by an invariant, then the coloring is refined by looking at the colors of adjacent nodes;
+  when refinement stabilizes, each node in the first nontrivial color class is individualized in turn and the process is repeated.
+  Each leaf of the search tree is a numbering of the nodes; the canonical form is the lexicographically smallest list of renumbered arrows among all leaves.
+  Two leaves giving the same list differ by an automorphism; leaves are compared with the first and the best leaf found so far, and the automorphisms obtained this way
+  that fix the individualized nodes are used to skip equivalent branches.
+  Since a branch is only skipped when it is the image of an explored branch under an automorphism fixing the individualized nodes, at each level of the first path
+  every node in the orbit of the individualized node is either reached by an automorphism found in its branch or by the automorphisms already found;
+  hence the automorphisms found generate the automorphism group, as in nauty.
+*/
+	class CanonicalLabeling {
+		int nodes;
+		vector<Relation> relations;
+		vector<vector<int>> incident_relations;
+		string first_certificate, best_certificate;
+		vector<int> first_numbering, best_numbering;
+		list<vector<int>> automorphisms;
+
+		static vector<int> ranks(const vector<int>& colors) {
+			vector<int> sorted_colors{colors};
+			sort(sorted_colors.begin(),sorted_colors.end());
+			sorted_colors.erase(unique(sorted_colors.begin(),sorted_colors.end()),sorted_colors.end());
+			vector<int> result(colors.size());
+			for (int i=0;i<colors.size();++i)
+				result[i]=lower_bound(sorted_colors.begin(),sorted_colors.end(),colors[i])-sorted_colors.begin();
+			return result;
+		}
+		static int number_of_classes(const vector<int>& colors) {
+			return colors.empty()? 0 : *max_element(colors.begin(),colors.end())+1;
+		}
+		int color_of(const vector<int>& colors, int node) const {
+			return node==NO_LABEL? nodes : colors[node];
+		}
+		//each node is characterized by its color and the colors seen through the relations it belongs to, according to its role in each relation
+		vector<Relation> signature(const vector<int>& colors, int node) const {
+			vector<Relation> result;
+			for (int r : incident_relations[node]) {
+				auto& relation=relations[r];
+				for (int role=0;role<3;++role)
+					if (relation[role]==node)
+						result.push_back({role,color_of(colors,relation[(role+1)%3]),color_of(colors,relation[(role+2)%3])});
+			}
+			sort(result.begin(),result.end());
+			return result;
+		}
+		vector<int> refine(vector<int> colors) const {
+			colors=ranks(colors);
+			int classes=number_of_classes(colors);
+			while (classes<nodes) {
+				vector<pair<int,vector<Relation>>> signatures;
+				for (int node=0;node<nodes;++node)
+					signatures.emplace_back(colors[node],signature(colors,node));
+				auto sorted_signatures=signatures;
+				sort(sorted_signatures.begin(),sorted_signatures.end());
+				sorted_signatures.erase(unique(sorted_signatures.begin(),sorted_signatures.end()),sorted_signatures.end());
+				if (sorted_signatures.size()==classes) break;
+				classes=sorted_signatures.size();
+				for (int node=0;node<nodes;++node)
+					colors[node]=lower_bound(sorted_signatures.begin(),sorted_signatures.end(),signatures[node])-sorted_signatures.begin();
+			}
+			return colors;
+		}
+		string certificate(const vector<int>& numbering) const {
+			vector<Relation> renumbered;
+			for (auto& relation: relations)
+				renumbered.push_back({numbering[relation[0]],numbering[relation[1]],color_of(numbering,relation[2])});
+			sort(renumbered.begin(),renumbered.end());
+			string result(1,static_cast<char>(nodes));
+			for (auto& relation: renumbered)
+				for (int node : relation) result.push_back(static_cast<char>(node));
+			return result;
+		}
+		void add_automorphism(const vector<int>& numbering1, const vector<int>& numbering2) {
+			vector<int> inverse_of_numbering1(nodes);
+			for (int node=0;node<nodes;++node) inverse_of_numbering1[numbering1[node]]=node;
+			vector<int> automorphism(nodes);
+			for (int node=0;node<nodes;++node) automorphism[node]=inverse_of_numbering1[numbering2[node]];
+			automorphisms.push_back(move(automorphism));
+		}
+		void leaf(const vector<int>& numbering) {
+			auto leaf_certificate=certificate(numbering);
+			if (!first_numbering.empty() && leaf_certificate==first_certificate) add_automorphism(first_numbering,numbering);
+			else if (!best_numbering.empty() && leaf_certificate==best_certificate) add_automorphism(best_numbering,numbering);
+			if (first_numbering.empty()) {
+				first_certificate=leaf_certificate;
+				first_numbering=numbering;
+			}
+			if (best_numbering.empty() || leaf_certificate<best_certificate) {
+				best_certificate=move(leaf_certificate);
+				best_numbering=numbering;
+			}
+		}
+		//nodes in the same orbit as node under the automorphisms found so far that fix the individualized nodes
+		bool in_orbit_of_explored(int node, const vector<int>& explored, const vector<int>& individualized) const {
+			vector<int> orbit_representative(nodes);
+			iota(orbit_representative.begin(),orbit_representative.end(),0);
+			auto find=[&orbit_representative] (int i) {
+				while (orbit_representative[i]!=i) i=orbit_representative[i]=orbit_representative[orbit_representative[i]];
+				return i;
+			};
+			for (auto& automorphism : automorphisms)
+				if (all_of(individualized.begin(),individualized.end(),[&automorphism] (int i) {return automorphism[i]==i;}))
+					for (int i=0;i<nodes;++i)
+						orbit_representative[find(i)]=find(automorphism[i]);
+			return any_of(explored.begin(),explored.end(),[&find,node] (int i) {return find(i)==find(node);});
+		}
+		void search(const vector<int>& colors, vector<int>& individualized) {
+			auto refined=refine(colors);
+			vector<int> class_size(nodes);
+			for (int color : refined) ++class_size[color];
+			auto target=find_if(class_size.begin(),class_size.end(),[] (int size) {return size>1;});
+			if (target==class_size.end()) {
+				leaf(refined);
+				return;
+			}
+			int target_color=target-class_size.begin();
+			vector<int> explored;
+			for (int node=0;node<nodes;++node) {
+				if (refined[node]!=target_color || in_orbit_of_explored(node,explored,individualized)) continue;
+				vector<int> individualized_colors(nodes);
+				for (int i=0;i<nodes;++i) individualized_colors[i]=2*refined[i]+(refined[i]==target_color && i!=node);
+				individualized.push_back(node);
+				search(individualized_colors,individualized);
+				individualized.pop_back();
+				explored.push_back(node);
+			}
+		}
+	public:
+		template<typename Arrows>
+		CanonicalLabeling(int nodes, const Arrows& arrows, const vector<int>& node_invariants) : nodes{nodes}, incident_relations(nodes) {
+			for (auto& arrow : arrows) {
+				Relation relation{arrow.node_in,arrow.node_out,label_of(arrow)};
+				for (int node: relation)
+					if (node!=NO_LABEL && (incident_relations[node].empty() || incident_relations[node].back()!=relations.size()))
+						incident_relations[node].push_back(relations.size());
+				relations.push_back(relation);
+			}
+			vector<int> individualized;
+			search(node_invariants,individualized);
+		}
+		string certificate() const {return best_certificate;}
+		//automorphisms found during the search; they generate the automorphism group
+		const list<vector<int>>& automorphisms_found() const {return automorphisms;}
+	};
+}
+
+//returns a string which identifies the tree up to renumbering of the nodes; node_invariants is any function of the nodes which is preserved by isomorphisms
+template<typename Arrows>
+string canonical_certificate(int nodes, const Arrows& arrows, const vector<int>& node_invariants) {
+	return canonical_form_impl::CanonicalLabeling{nodes,arrows,node_invariants}.certificate();
+}
+
+//a set of generators of the automorphism group of the tree, found as a byproduct of the canonical form
+template<typename Arrows>
+list<vector<int>> automorphism_group_generators(int nodes, const Arrows& arrows, const vector<int>& node_invariants) {
+	return canonical_form_impl::CanonicalLabeling{nodes,arrows,node_invariants}.automorphisms_found();
+}
+
+#endif
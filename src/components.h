@@ -21,22 +21,20 @@
 #include "labeled_tree.h"
 
 class Components {
-	vector<set<int>> components;
+	vector<uint64_t> components;	//each component is represented as a bitmask
 	auto component_with(int i) {
-		auto I=components.begin();
-		while (I->find(i)==I->end()) ++I;
-		return I;
+		return find_if(components.begin(),components.end(),[i] (uint64_t component) {return component>>i & 1;});
 	}
 	void connect(int i, int j) {
 		auto I=component_with(i), J=component_with(j);
 		if (I!=J) {
-			I->insert(J->begin(),J->end());
+			*I|=*J;
 			components.erase(J);		
 		}
 	}
 public:
 	Components(const LabeledTree& diagram) {
-		for (int i=0;i<diagram.number_of_nodes();++i) components.push_back({i});
+		for (int i=0;i<diagram.number_of_nodes();++i) components.push_back(uint64_t{1}<<i);
 		for (auto& weight : diagram.weights()) {		
 			connect(weight.node_in1, weight.node_in2);
 			connect(weight.node_in1,weight.node_out);
@@ -102,11 +102,13 @@ public:
 		vector<int> result;
 		auto centre=centre_basis(nodes, weights);
 		auto gprimeperp=gprimeperp_basis(nodes, weights);
+		auto reachable_from=reachable_from_masks(nodes,weights);
+		auto not_commuting_with=not_commuting_with_masks(nodes,weights);
 		for (int i=0;i<nodes;++i)
 			if (all_of(centre.begin(),centre.end(),
-				[&weights,i](int v_in_centre) {return reachable(weights,v_in_centre, i);})
+				[&reachable_from,i](int v_in_centre) {return reachable_from[i]>>v_in_centre & 1;})
 			 	&& all_of(gprimeperp.begin(),gprimeperp.end(),
-						[&weights,i](int v_in_gprimeperp) {return reachable(weights,i,v_in_gprimeperp) || !commutes(weights,i,v_in_gprimeperp);})
+						[&reachable_from,&not_commuting_with,i](int v_in_gprimeperp) {return (reachable_from[v_in_gprimeperp]>>i & 1) || (not_commuting_with[i]>>v_in_gprimeperp & 1);})
 			)
 				nodes_for_lorentzian_diagonal_ricci_flat.push_back(i);
 	}
@@ -159,20 +161,26 @@ private:
 		return {basis.begin(),basis.end()};
 	}
 
+	//bit j of the i-th element is set if j is reachable from i, i.e. there is a weight with i as node_in1 or node_in2 and j as node_out
 	template<typename Weights>
-	static bool reachable(Weights&& weights, int node, int from) {
-		for (auto weight : weights) 
-			if (weight.node_in1==from && weight.node_out==node) return true;
-			else if (weight.node_in2==from && weight.node_out==node) return true;	
-		return false;
+	static vector<uint64_t> reachable_from_masks(int nodes, Weights&& weights) {
+		vector<uint64_t> result(nodes);
+		for (auto weight : weights) {
+			result[weight.node_in1]|=uint64_t{1}<<weight.node_out;
+			result[weight.node_in2]|=uint64_t{1}<<weight.node_out;
+		}
+		return result;
 	}
 
+	//bit j of the i-th element is set if there is a weight with {i,j} as {node_in1,node_in2}
 	template<typename Weights>
-	static bool commutes(Weights&& weights, int node1, int node2) {
-		return all_of(weights.begin(),weights.end(),
-			[node1,node2] (auto& weight) {
-				return (node1!=weight.node_in1 || node2!=weight.node_in2) && (node1!=weight.node_in2 || node2!=weight.node_in1);
-		});
+	static vector<uint64_t> not_commuting_with_masks(int nodes, Weights&& weights) {
+		vector<uint64_t> result(nodes);
+		for (auto weight : weights) {
+			result[weight.node_in1]|=uint64_t{1}<<weight.node_in2;
+			result[weight.node_in2]|=uint64_t{1}<<weight.node_in1;
+		}
+		return result;
 	}
 
 };
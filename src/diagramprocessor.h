@@ -116,6 +116,7 @@ constexpr class lie_algebra_list_tag {} lie_algebra_list;
 
 class DiagramProcessor  {
   Filter filter_; //REFACTOR: consider removing the filter from this class (impacts nice.cpp)
+  EnumerationOptions enumeration_options_;
   unique_ptr<DiagramProcessorImpl> processor;
 public:
   DiagramProcessor(only_diagrams_tag) : processor{new DiagramProcessorImpl()} {}
@@ -138,6 +139,9 @@ public:
     processor->adapt_to_filter(filter_);
   } 
   const Filter& filter() const {return filter_;}
+  void set_partition_threads(int threads) {enumeration_options_.threads=threads;}
+  void set(EnumerationOption option) {enumeration_options_.set(option);}
+  EnumerationOptions enumeration_options() const {return enumeration_options_;}
   void set(ProcessingOption option) {processor->set(option);}
   void set(DiagramDataOption option) {processor->set(option);}
  	void set_sign_configuration_limit(int limit) {processor->set_sign_configuration_limit(limit);}
@@ -17,6 +17,7 @@
 */
 #include "filter.h"
 #include "horizontal.h"
+#include "taskrunner.h"
 
 using namespace std;
 
@@ -29,22 +30,38 @@ void remove_trees(list<LabeledTree>& trees, const Filter& filter,DiagramDataOpti
 }
 
 
-list<LabeledTree> nice_diagrams(vector<int> partition, const Filter& filter,DiagramDataOptions options) {
+list<LabeledTree> nice_diagrams(vector<int> partition, const Filter& filter,DiagramDataOptions options, EnumerationOptions enumeration_options) {
   nice_log<<"nice diagrams of partition "<<horizontal(partition)<<endl;
   if (partition[0]<2) {
     nice_log<<"no trees"<<endl;
     return {};
   }
+	auto to_complete=trees_to_complete(partition,enumeration_options);
+	vector<Tree> trees{std::make_move_iterator(to_complete.begin()),std::make_move_iterator(to_complete.end())};
+	nice_log<<trees.size()<<" trees to complete using "<<enumeration_options.threads<<" threads"<<endl;
+	//each tree to complete has its own slot, so threads never write to the same container; since completions of distinct trees are never equivalent, merging the slots in order gives the same result as a sequential computation.
+	//Within each slot, trees are labeled as soon as they are generated; the result is sorted by the hash of the underlying tree as in trees(partition)
+	vector<map<int,list<LabeledTree>>> labelings_by_tree_hash(trees.size());
+	run_in_parallel(trees.size(),enumeration_options.threads, [&] (int i) {
+		nice_log<<"completing tree "<<i+1<<"/"<<trees.size()<<endl;
+		for_each_completion(trees[i],partition[0],[&] (const Tree& tree) {
+			LabeledTree labeled_tree{tree};
+			auto labelings = filter.has_N1N2N3()? labeled_tree.labelings() : labeled_tree.nice_labelings();
+			remove_trees(labelings, filter,options);
+			remove_equivalent_trees_same_hash(labelings);
+			auto& labelings_with_same_hash=labelings_by_tree_hash[i][tree.hash()];
+			labelings_with_same_hash.splice(labelings_with_same_hash.end(),labelings);
+		},enumeration_options);
+	});
+	map<int,list<LabeledTree>> merged;
+	for (auto& slot : labelings_by_tree_hash)
+		for (auto& hash_and_labelings : slot) {
+			auto& labelings_with_same_hash=merged[hash_and_labelings.first];
+			labelings_with_same_hash.splice(labelings_with_same_hash.end(),hash_and_labelings.second);
+		}
 	list<LabeledTree> result;
-	auto counter=nice_log.counter("Labeling tree ",50);
-	for (auto& tree : trees(partition)) {
-	  nice_log<<counter;
-		LabeledTree labeled_tree{tree};
-		auto labelings = labeled_tree.labelings();
-		remove_trees(labelings, filter,options);
-		remove_equivalent_trees_same_hash(labelings);
-		result.splice(result.end(),labelings);
-	}
+	for (auto& hash_and_labelings : merged)
+		result.splice(result.end(),hash_and_labelings.second);
 	return result;
 }
 
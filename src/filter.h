@@ -22,6 +22,7 @@
 #include "includes.h"
 #include "adinvariantobstruction.h"
 #include "components.h"
+#include "weightmatrix.h"
 
 class EqualityOrInequality {
 	enum class Operand : char {NO_CONDITION, EQUALS='=',LESS_THAN='<',GREATER_THAN='>'};
@@ -70,21 +71,33 @@ public:
  	void only_kernel_MDelta_dimension(EqualityOrInequality kernel_dimension) {kernel_dimension_=kernel_dimension;}
  	void only_cokernel_MDelta_dimension(EqualityOrInequality cokernel_dimension) {cokernel_dimension_=cokernel_dimension;}
  	void only_irreducible() {only_irreducible_=true;}
+private:
+  bool requires_rank_of_M_Delta() const {return kernel_dimension_.nontrivial() || cokernel_dimension_.nontrivial();}
+  bool meets_conditions_on_rank(const WeightMatrix& weight_matrix) const {
+    int rank=weight_matrix.rank_over_Q();
+    return kernel_dimension_.verified_by(weight_matrix.cols()-rank) && cokernel_dimension_.verified_by(weight_matrix.rows()-rank);
+  }
+  bool requires_properties() const {return only_traceless_derivations_ || only_with_metric_ || !indeterminate(simple_nikolayevsky_);}
+  bool meets_conditions_on_properties(const DiagramProperties& properties) const {
+    if (only_traceless_derivations_ && !properties.are_all_derivations_traceless()) return false;
+    if (only_with_metric_ && !properties.potentially_admits_metrics()) return false;
+    if (simple_nikolayevsky_ && !properties.simple_nikolayevsky_derivation()) return false;
+    if (!simple_nikolayevsky_ && properties.simple_nikolayevsky_derivation()) return false;
+    return true;
+  }
+public:
   bool trivial() const {
   	return !(only_traceless_derivations_||kernel_dimension_.nontrivial()||cokernel_dimension_.nontrivial()||only_nontrivial_automorphisms_ || only_with_metric_ || only_passing_obstruction_for_ad_invariant_metric_ || only_irreducible_ ) && indeterminate(simple_nikolayevsky_);}
+  //the conditions are tested in order of cost: first those that only depend on the diagram, then those that depend on the rank of M_Delta, 
+  //and finally those that depend on the weight basis and its properties, which are only computed if one of these conditions is requested
   bool meets(const LabeledTree& diagram, DiagramDataOptions options) const {
   	if (!allow_nonnice && !satisfies_formal_jacobi(diagram)) return false;
   	if (trivial()) return true;
-    auto& properties = diagram.weight_basis(options).properties();
-    if (only_traceless_derivations_ && !properties.are_all_derivations_traceless()) return false;
-    if (!kernel_dimension_.verified_by(properties.dimension_kernel_M_Delta())) return false;
-    if (!cokernel_dimension_.verified_by(properties.dimension_cokernel_M_Delta())) return false;
-    if (only_nontrivial_automorphisms_ && !properties.has_nontrivial_automorphisms()) return false;
-    if (only_with_metric_ && !properties.potentially_admits_metrics()) return false;
-    if (only_passing_obstruction_for_ad_invariant_metric_ && !passes_obstruction_for_ad_invariant_metric(diagram)) return false;
-    if (simple_nikolayevsky_ && !properties.simple_nikolayevsky_derivation()) return false;
-    if (!simple_nikolayevsky_ && properties.simple_nikolayevsky_derivation()) return false;
     if (only_irreducible_ && Components(diagram).size()>1) return false;
+    if (only_nontrivial_automorphisms_ && diagram.nontrivial_automorphisms().empty()) return false;
+    if (only_passing_obstruction_for_ad_invariant_metric_ && !passes_obstruction_for_ad_invariant_metric(diagram)) return false;
+    if (requires_rank_of_M_Delta() && !meets_conditions_on_rank(WeightMatrix{diagram.weights(),diagram.number_of_nodes()})) return false;
+    if (requires_properties() && !meets_conditions_on_properties(diagram.weight_basis(options).properties())) return false;
     return true;
   }
   
@@ -93,6 +106,6 @@ public:
 
 };
 
-list<LabeledTree> nice_diagrams(vector<int> partition, const Filter& filter,DiagramDataOptions options);
+list<LabeledTree> nice_diagrams(vector<int> partition, const Filter& filter,DiagramDataOptions options, EnumerationOptions enumeration_options={});
 void remove_trees(list<LabeledTree>& trees, const Filter& filter,DiagramDataOptions options);
 #endif
@@ -176,6 +176,156 @@ std::ostream& operator<<(std::ostream& os, const PivotableMatrix& m) {
 }
 
 
+/* Fraction-free (Bareiss) elimination on a matrix with numeric entries, following the same pivoting strategy as PivotableMatrix,
+  so that the pivots, and hence the independent rows and the solutions, are the same. Entries are stored as Integer rather than ex;
+  with Integer=int64_t, an overflow makes elimination fail, and the caller falls back to exact arithmetic with GiNaC::numeric.
+*/
+inline bool fraction_free_step(int64_t& result, int64_t pivot, int64_t entry, int64_t pivot_col_entry, int64_t pivot_row_entry, int64_t last_pivot) {
+  //products of 64-bit integers fit in 128 bits, and so does their difference; the division is exact by Sylvester's identity, but this is checked anyway
+  __int128 numerator=static_cast<__int128>(pivot)*entry - static_cast<__int128>(pivot_col_entry)*pivot_row_entry;
+  if (numerator%last_pivot) return false;
+  __int128 quotient=numerator/last_pivot;
+  if (quotient>numeric_limits<int64_t>::max() || quotient<numeric_limits<int64_t>::min()) return false;
+  result=quotient;
+  return true;
+}
+
+inline bool fraction_free_step(numeric& result, const numeric& pivot, const numeric& entry, const numeric& pivot_col_entry, const numeric& pivot_row_entry, const numeric& last_pivot) {
+  result=(pivot*entry - pivot_col_entry*pivot_row_entry)/last_pivot;
+  return true;
+}
+
+inline optional<int64_t> to_exact(ex x, int64_t) {
+  if (!is_a<numeric>(x)) return nullopt;
+  auto& as_numeric=ex_to<numeric>(x);
+  if (!as_numeric.is_integer() || abs(as_numeric).compare(numeric{numeric_limits<long>::max()})>0) return nullopt;
+  return as_numeric.to_long();
+}
+
+inline optional<numeric> to_exact(ex x, const numeric&) {
+  if (!is_a<numeric>(x)) return nullopt;
+  return ex_to<numeric>(x);
+}
+
+inline bool exact_is_zero(int64_t x) {return x==0;}
+inline bool exact_is_zero(const numeric& x) {return x.is_zero();}
+inline ex to_ex(int64_t x) {return numeric{static_cast<long>(x)};}
+inline ex to_ex(const numeric& x) {return x;}
+
+template<typename Integer>
+class FractionFreeMatrix {
+  int no_rows, no_cols;
+  vector<Integer> entries;
+  vector<int> actual_column_position;
+  int pivots_used=0;
+  Integer last_pivot=1;
+  FractionFreeMatrix(int rows, int cols) : no_rows{rows}, no_cols{cols}, entries(rows*cols), actual_column_position(cols) {
+    iota(actual_column_position.begin(),actual_column_position.end(),0);
+  }
+  Integer& at(int i, int j) {return entries[i*no_cols+actual_column_position[j]];}
+  int first_non_zero_element_in_row(int i) const {
+    int k = pivots_used;
+    while (k<no_cols && exact_is_zero(at(i,k))) ++k;
+    return k;
+  }
+  bool row_is_zero(int row, int cols) const {
+    for (int j=0;j<cols;++j) if (!exact_is_zero(operator()(row,j))) return false;
+    return true;
+  }
+public:
+  //returns nullopt if the entries of m cannot be represented as Integer
+  static optional<FractionFreeMatrix> from(const Matrix& m) {
+    FractionFreeMatrix result{m.rows(),m.cols()};
+    for (int i=0;i<m.rows();++i)
+    for (int j=0;j<m.cols();++j) {
+      auto entry=to_exact(m(i,j),Integer{});
+      if (!entry) return nullopt;
+      result.entries[i*m.cols()+j]=*entry;
+    }
+    return result;
+  }
+  int rows() const {return no_rows;}
+  int cols() const {return no_cols;}
+  const Integer& at(int i, int j) const {return entries[i*no_cols+actual_column_position[j]];}
+  const Integer& operator()(int i, int j) const {return entries[i*no_cols+j];}
+
+  //considers the first cols columns only
+  bool pivot_in_row(int i, int cols) {
+    int j=first_non_zero_element_in_row(i);
+    if (j>=cols) return false;
+    swap(actual_column_position[j],actual_column_position[pivots_used]);
+    return true;
+  }
+  //returns false on overflow
+  bool eliminate_past_row(int pivot_row) {
+    int pivot_col=pivots_used++;
+    Integer pivot=at(pivot_row,pivot_col);
+    for (int i=pivot_row+1; i<no_rows; ++i) {
+      for (int j=pivot_col+1; j<no_cols; ++j)
+        if (!fraction_free_step(at(i,j),pivot,at(i,j),at(i,pivot_col),at(pivot_row,j),last_pivot)) return false;
+      at(i,pivot_col)=0;
+    }
+    last_pivot=pivot;
+    return true;
+  }
+  vector<pair<int,int>> pivots(int cols) const {
+    vector<pair<int,int>> result;
+    int row=0;
+    for (int pivot=0;pivot<pivots_used;++pivot) {
+      while (row_is_zero(row,cols)) ++row;
+      result.emplace_back(row,actual_column_position[pivot]);
+      ++row;
+    }
+    return result;
+  }
+};
+
+template<typename Integer>
+optional<vector<int>> exact_independent_rows(const Matrix& m) {
+  auto M=FractionFreeMatrix<Integer>::from(m);
+  if (!M) return nullopt;
+  vector<int> independent_rows;
+  for (int i=0; i<M->rows(); ++i)
+    if (M->pivot_in_row(i,M->cols())) {
+      independent_rows.push_back(i);
+      if (!M->eliminate_past_row(i)) return nullopt;
+    }
+  return independent_rows;
+}
+
+//solves the system by back substitution as solve_by_back_substitution does, leaving the variables corresponding to non-pivot columns free; returns an empty vector if there is no solution
+template<typename Integer>
+optional<exvector> exact_solve(const Matrix& complete_matrix, const exvector& variables) {
+  auto M=FractionFreeMatrix<Integer>::from(complete_matrix);
+  if (!M) return nullopt;
+  int no_variables=M->cols()-1;
+  assert(variables.size()==no_variables);
+  for (int i=0; i<M->rows(); ++i)
+    if (M->pivot_in_row(i,no_variables) && !M->eliminate_past_row(i)) return nullopt;
+  auto pivots=M->pivots(no_variables);
+  for (auto x : pivots)
+    nice_log<<"pivot "<<x.first<<" "<<x.second<<endl;
+  vector<bool> row_has_pivot(M->rows());
+  for (auto pivot : pivots) row_has_pivot[pivot.first]=true;
+  for (int i=0;i<M->rows();++i)
+    if (!row_has_pivot[i] && !exact_is_zero((*M)(i,no_variables))) {
+      nice_log<<"no solution"<<endl;
+      return exvector{};
+    }
+  exvector solution=variables;
+  for (auto pivot : pivots) solution[pivot.second]=0;
+  for (auto i=pivots.rbegin();i!=pivots.rend();++i) {
+    int row=i->first, column=i->second;
+    ex sum;
+    for (int col=0;col<no_variables;++col)
+      sum+=solution[col]*to_ex((*M)(row,col));
+    sum-=to_ex((*M)(row,no_variables));
+    solution[column]=-sum/to_ex((*M)(row,column));
+  }
+  return solution;
+}
+
+
 template<typename Reducer>
 vector<int> independent_rows_in(Matrix&& m, Reducer&& reducer) {
   vector<int> independent_rows;
@@ -190,6 +340,8 @@ vector<int> independent_rows_in(Matrix&& m, Reducer&& reducer) {
 }
 
 vector<int> independent_rows_over_Q(Matrix&& m) {
+  if (auto result=exact_independent_rows<int64_t>(m)) return *result;
+  if (auto result=exact_independent_rows<numeric>(m)) return *result;
   static auto reducer = [] (ex x) {return x.expand();};
   return independent_rows_in(move(m),reducer);
 }
@@ -299,6 +451,8 @@ exvector solve(const Matrix& complete_matrix, const exvector& variables, Reducer
 }
 
 exvector solve_over_Q(const Matrix& complete_matrix, const exvector& variables) {
+  if (auto result=exact_solve<int64_t>(complete_matrix,variables)) return *result;
+  if (auto result=exact_solve<numeric>(complete_matrix,variables)) return *result;
   static auto reducer = [] (ex x) {return x.expand();};
   return solve(complete_matrix,variables, reducer);
 }
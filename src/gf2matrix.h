@@ -0,0 +1,128 @@
+/*  Copyright (C) 2018-2023 by Diego Conti, diego.conti@unipi.it
+
+    This file is part of DEMONbLAST
+
+    DEMONbLAST is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DEMONbLAST is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DEMONbLAST.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GF2MATRIX_H
+#define GF2MATRIX_H
+
+#include "includes.h"
+
+/* A matrix over Z_2 with at most 64 columns; each row is stored as a bitmask, bit j representing the entry in column j.
+  Gaussian elimination then reduces to XOR of rows. The generic Matrix class with reduce_mod_Z2 gives the same results and is kept as a reference implementation.
+*/
+class GF2Matrix {
+	int no_cols;
+	vector<uint64_t> row_bits;
+	//a row of the reduced echelon form, with its constant term; pivot is its lowest set bit
+	struct EchelonRow {
+		uint64_t bits;
+		int pivot;
+		bool constant_term;
+	};
+	//reduces bits against the echelon rows found so far; since each echelon row vanishes on the pivots of the others, one pass suffices
+	static void reduce(uint64_t& bits, bool& constant_term, const vector<EchelonRow>& echelon) {
+		for (auto& row : echelon)
+			if (bits>>row.pivot & 1) {
+				bits^=row.bits;
+				constant_term^=row.constant_term;
+			}
+	}
+	//reduced echelon form of the system with the given constant terms (all zero if empty), or nullopt if the system is not solvable
+	optional<vector<EchelonRow>> echelon_form(const vector<bool>& constant_terms, vector<int>* independent_rows=nullptr) const {
+		vector<EchelonRow> echelon;
+		for (int i=0;i<rows();++i) {
+			uint64_t bits=row_bits[i];
+			bool constant_term=constant_terms.empty()? false : constant_terms[i];
+			reduce(bits,constant_term,echelon);
+			if (!bits) {
+				if (constant_term) return nullopt;
+				continue;
+			}
+			EchelonRow new_row{bits,__builtin_ctzll(bits),constant_term};
+			for (auto& row : echelon)
+				if (row.bits>>new_row.pivot & 1) {
+					row.bits^=new_row.bits;
+					row.constant_term^=new_row.constant_term;
+				}
+			echelon.push_back(new_row);
+			if (independent_rows) independent_rows->push_back(i);
+		}
+		return echelon;
+	}
+public:
+	explicit GF2Matrix(int cols) : no_cols{cols} {assert(cols<=64);}
+	void add_row(uint64_t bits) {row_bits.push_back(bits);}
+	int rows() const {return row_bits.size();}
+	int cols() const {return no_cols;}
+	uint64_t row(int i) const {return row_bits[i];}
+
+	//the indices of the rows which are not linear combinations of the preceding rows, as in independent_rows_over_Z2
+	vector<int> independent_rows() const {
+		vector<int> result;
+		echelon_form({},&result);
+		return result;
+	}
+	int rank() const {return independent_rows().size();}
+
+	//requires at most 64 rows
+	GF2Matrix transpose() const {
+		assert(rows()<=64);
+		GF2Matrix result{rows()};
+		for (int j=0;j<no_cols;++j) {
+			uint64_t column=0;
+			for (int i=0;i<rows();++i)
+				if (row_bits[i]>>j & 1) column|=uint64_t{1}<<i;
+			result.add_row(column);
+		}
+		return result;
+	}
+
+	//the image of x, as a vector with one entry for each row
+	vector<bool> image_of(uint64_t x) const {
+		vector<bool> result(rows());
+		for (int i=0;i<rows();++i) result[i]=__builtin_parityll(row_bits[i] & x);
+		return result;
+	}
+
+	//a solution x of the system with the given constant terms, with the non-pivot variables set to zero, or nullopt if the system is not solvable
+	optional<uint64_t> solve(const vector<bool>& constant_terms) const {
+		assert(constant_terms.size()==rows());
+		auto echelon=echelon_form(constant_terms);
+		if (!echelon) return nullopt;
+		uint64_t x=0;
+		for (auto& row : *echelon)
+			if (row.constant_term) x|=uint64_t{1}<<row.pivot;
+		return x;
+	}
+
+	//a basis of the space of solutions of the homogeneous system
+	vector<uint64_t> kernel() const {
+		auto echelon=*echelon_form({});
+		uint64_t pivots=0;
+		for (auto& row : echelon) pivots|=uint64_t{1}<<row.pivot;
+		vector<uint64_t> result;
+		for (int j=0;j<no_cols;++j) {
+			if (pivots>>j & 1) continue;
+			uint64_t x=uint64_t{1}<<j;
+			for (auto& row : echelon)
+				if (row.bits>>j & 1) x|=uint64_t{1}<<row.pivot;
+			result.push_back(x);
+		}
+		return result;
+	}
+};
+
+#endif
@@ -72,16 +72,23 @@ bool affinespace_intersects_orthant(vector<Z2> epsilon, exvector generic_vector)
 
 
 //condition 2
+//the test only depends on the image of epsilon in Z_2^rows, so it is performed once for each coset of the kernel of M_Delta mod 2
 list<pair<SignConfiguration,SignConfiguration>> signatures_compatible_with_X(const WeightMatrix& weight_matrix,const exvector& X)
 {
 	assert(weight_matrix.rows()==0 || !X.empty());
+	map<PackedZ2Vector,bool> image_intersects_orthant;
+	vector<pair<uint64_t,PackedZ2Vector>> compatible;
+	weight_matrix.for_each_image_mod2([&] (uint64_t epsilon, const PackedZ2Vector& MDelta2epsilon) {
+		auto known=image_intersects_orthant.find(MDelta2epsilon);
+		if (known==image_intersects_orthant.end())
+			known=image_intersects_orthant.emplace(MDelta2epsilon,affinespace_intersects_orthant<Unknown>(unpack(MDelta2epsilon,weight_matrix.rows()), X)).first;
+		if (known->second) compatible.emplace_back(epsilon,MDelta2epsilon);
+	});
+	//list the results in the order of SignConfiguration::all_configurations, i.e. by increasing bitmask
+	sort(compatible.begin(),compatible.end());
 	list<pair<SignConfiguration,SignConfiguration>> result;
-	for (auto epsilon : SignConfiguration::all_configurations(weight_matrix.cols())) {
-		auto MDelta2epsilon=weight_matrix.image_of(sign_configuration_to_vector(weight_matrix.cols(),epsilon));
-//		if (all_of(MDelta2epsilon.begin(),MDelta2epsilon.end(),[](Z2 z) {return z==0;})) continue;	//do not consider "trivial" sign configurations
-			if (affinespace_intersects_orthant<Unknown>((MDelta2epsilon), X))
-				result.push_back(make_pair(epsilon,vector_to_sign_configuration(MDelta2epsilon)));
-	}
+	for (auto& epsilon_and_image : compatible)
+		result.push_back(make_pair(bitmask_to_sign_configuration(weight_matrix.cols(),epsilon_and_image.first),vector_to_sign_configuration(unpack(epsilon_and_image.second,weight_matrix.rows()))));
 	return result;
 }
 
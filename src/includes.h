@@ -12,6 +12,7 @@
 #include <map>
 #include <utility>
 #include <set>
+#include <unordered_set>
 #include <initializer_list>
 
 #include <string>
@@ -21,6 +22,8 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <cstdint>
+#include <type_traits>
 
 #include <stdexcept>
 #include <cassert>
@@ -44,6 +47,7 @@ using std::map;
 using std::pair;
 using std::make_pair;
 using std::set;
+using std::unordered_set;
 using std::initializer_list;
 
 using std::string;
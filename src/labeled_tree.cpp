@@ -22,41 +22,8 @@
 
 using namespace std;
 
-list<LabeledTree> LabeledTree::labelings() const  {
-		auto node=node_with_less_unlabeled_incoming_arrows();
-		if (node==NO_NODE) return {*this};
-		else return labelings_with_hint(node);
-}
-
-list<LabeledTree> LabeledTree::labelings_with_hint(int hint_node) const {
-		list<LabeledTree> result;
-		auto unlabeled_arrows = unlabeled_arrows_pointing_to(hint_node);
-		auto arrow=unlabeled_arrows.begin();
-		auto first=*arrow;
-		while (++arrow!=unlabeled_arrows.end()) {
-			auto labelings=labelings_with_bracket(hint_node, first, *arrow);
-			result.splice(result.end(),labelings);	
-		}
-		return result;
-}
-
-LabeledTree LabeledTree::with_added_label(int to_node, int from_1, int from_2) const {
-   auto arrows_with_added_label = arrows();	
-   auto add_label = [to_node,from_1,from_2](LabeledArrow& arrow) {
-		if (arrow.node_in==from_1 && arrow.node_out==to_node) arrow.label=from_2;
-		else if (arrow.node_in==from_2 && arrow.node_out==to_node) arrow.label=from_1;    
-   };
-   for_each(arrows_with_added_label.begin(), arrows_with_added_label.end(), add_label);
-	return {*this, move(arrows_with_added_label)};
-}
-
-list<LabeledTree> LabeledTree::labelings_with_bracket(int to_node, int from_1, int from_2) const {
-	//check that from_1 does not already have an outgoing arrow with label from_2; equivalently, that the bracket [from_1,from_2] does not already appear
-	auto is_same_bracket=[from_1,from_2] (const LabeledArrow& arrow) {
- 		return arrow.node_in==from_1 && arrow.label==from_2;
- 	};
-   if (any_of(arrows().begin(),arrows().end(),is_same_bracket)) return {};
-   else return with_added_label(to_node,from_1,from_2).labelings(); 
+LabeledTree LabeledTree::with_arrows(const vector<LabeledArrow>& labeled_arrows) const {
+	return {*this, list<LabeledArrow>{labeled_arrows.begin(),labeled_arrows.end()}};
 }
 
 vector<int> LabeledTree::unlabeled_arrows_pointing_to(int node) const {
@@ -165,6 +132,22 @@ public:
 	bool has_repetition() const {  
 		return n1==n2 || n2==n3;
 	}
+	//numbers the triplets without repetition of elements in {0,...,n-1} by 0,...,binomial(n,3)-1, for any n
+	int packed() const {
+		assert(!has_repetition());
+		return n1+n2*(n2-1)/2+n3*(n3-1)*(n3-2)/6;
+	}
+	static int number_of_packed_triplets(int n) {
+		return n*(n-1)*(n-2)/6;
+	}
+	static Triplet unpack(int packed) {
+		int n3=2;
+		while ((n3+1)*n3*(n3-1)/6<=packed) ++n3;
+		packed-=n3*(n3-1)*(n3-2)/6;
+		int n2=1;
+		while ((n2+1)*n2/2<=packed) ++n2;
+		return {packed-n2*(n2-1)/2,n2,n3};
+	}
 };
 
 ostream& operator<<(ostream& os, Triplet triplet) {
@@ -172,58 +155,161 @@ ostream& operator<<(ostream& os, Triplet triplet) {
 }
 
 
+//the multiplicities of the double arrows {i,j,k}->h obtained by concatenating a weight {i,j}->l with a weight {l,k}->h, stored densely by h and packed triplet;
+//double arrows of the form j->^i k->^i h are ignored
 class DoubleIncomingArrows {
   friend ostream& operator<<(ostream&, const DoubleIncomingArrows&);
-	using DoubleArrowsWithMultiplicity = map<Triplet,int>;
-	vector<DoubleArrowsWithMultiplicity> double_incoming_arrows;
+	int triplets;
+	vector<int> multiplicities;		//at position h*triplets+t
 	void add_concatenated_arrow(Triplet double_arrow, int out) {
-		if (!double_arrow.has_repetition())			//ignore double arrows of the form j->^i k->^i h
-			++(double_incoming_arrows[out][double_arrow]);
-	}
-	void add_concatenated_arrow(Weight i, Weight j) {
-		if (i.node_out == j.node_in1) add_concatenated_arrow({i.node_in1, i.node_in2, j.node_in2},j.node_out);
-		else if (i.node_out == j.node_in2) add_concatenated_arrow({i.node_in1, i.node_in2, j.node_in1},j.node_out);
+		if (!double_arrow.has_repetition())
+			++multiplicities[out*triplets+double_arrow.packed()];
 	}
 public:
-	DoubleIncomingArrows(const LabeledTree& tree) : double_incoming_arrows{tree.number_of_nodes()} {
+	DoubleIncomingArrows(const LabeledTree& tree) : triplets{Triplet::number_of_packed_triplets(tree.number_of_nodes())}, multiplicities(tree.number_of_nodes()*triplets) {
+		vector<vector<Weight>> weights_to(tree.number_of_nodes());
 		auto weights = tree.weights();
-		for (auto i=weights.begin();i!=weights.end();++i) {
-			auto j=i;
-			while (++j!=weights.end()) {
-				add_concatenated_arrow(*i,*j);	
-				add_concatenated_arrow(*j,*i);	
-			}
+		for (auto& weight : weights) weights_to[weight.node_out].push_back(weight);
+		for (auto& weight : weights) {
+			for (auto& concatenated : weights_to[weight.node_in1]) add_concatenated_arrow({concatenated.node_in1, concatenated.node_in2, weight.node_in2},weight.node_out);
+			for (auto& concatenated : weights_to[weight.node_in2]) add_concatenated_arrow({concatenated.node_in1, concatenated.node_in2, weight.node_in1},weight.node_out);
 		}
 	}
-	bool has_double_incoming_arrow_with_multiplicity_three() {
-   	  for (auto arrow: double_incoming_arrows)
-	    for (auto pair : arrow)
-	      if (pair.second>2) {
-	        nice_log<<"double incoming arrow "<<pair.first<<" has multiplicity "<<pair.second<<endl; 
-	        return true;
-	        }
-      return false;
+	bool has_double_incoming_arrow_with_multiplicity_three() const {
+		auto i=find_if(multiplicities.begin(),multiplicities.end(),[] (int multiplicity) {return multiplicity>2;});
+		if (i==multiplicities.end()) return false;
+		nice_log<<"double incoming arrow "<<Triplet::unpack((i-multiplicities.begin())%triplets)<<" has multiplicity "<<*i<<endl; 
+		return true;
 	}
-	
+	//all the double arrows that appear have multiplicity greater than one
 	bool formal_jacobi() const {		
-		static auto has_multiplicity_greater_than_one = [](pair<Triplet,int> double_arrow_with_multiplicity) {return double_arrow_with_multiplicity.second>1;};
-		static auto all_multiplicities_greater_than_one=
-			 [](const DoubleArrowsWithMultiplicity& arrows) {return all_of(arrows.begin(),arrows.end(),has_multiplicity_greater_than_one);};
-   return all_of(double_incoming_arrows.begin(),double_incoming_arrows.end(),all_multiplicities_greater_than_one);
+		return find(multiplicities.begin(),multiplicities.end(),1)==multiplicities.end();
 	}
 };
 
 ostream& operator<<(ostream& os, const DoubleIncomingArrows& d) {
-		for (int i=0;i<d.double_incoming_arrows.size();++i) {
+		for (int i=0;i*d.triplets<d.multiplicities.size();++i) {
 			os<<"node "<<i+1<<endl;
-			for (auto double_arrow_with_multiplicity : d.double_incoming_arrows[i])
-				os<<double_arrow_with_multiplicity.first<<" * "<<double_arrow_with_multiplicity.second<<endl;
+			for (int t=0;t<d.triplets;++t)
+				if (d.multiplicities[i*d.triplets+t]) os<<Triplet::unpack(t)<<" * "<<d.multiplicities[i*d.triplets+t]<<endl;
 		}
 	 return os;
 }
 
 
 
+//Enumerates the labelings of a tree by assigning and retracting labels in place on a single copy of the arrows; a LabeledTree is only constructed
+//for complete labelings. At each step, the node with the least nonzero number of unlabeled incoming arrows is considered, and the first of these arrows
+//is paired with each of the others in turn, as long as the corresponding bracket does not already appear.
+class Labeler {
+	static constexpr int NO_NODE=-1;
+	const LabeledTree& tree;
+	int nodes;
+	vector<LabeledArrow> arrows;
+	vector<int> arrow_index;		//index of the arrow i->j in arrows at position i*nodes+j, or NO_NODE
+	vector<int> unlabeled_incoming_arrows;
+	vector<uint64_t> brackets;		//bit j of brackets[i] is set if i has an outgoing arrow labeled j
+	bool only_nice;
+	list<LabeledTree> result;
+
+	bool has_arrow(int node_in, int node_out) const {return arrow_index[node_in*nodes+node_out]!=NO_NODE;}
+	LabeledArrow& arrow(int node_in, int node_out) {return arrows[arrow_index[node_in*nodes+node_out]];}
+	int label(int node_in, int node_out) const {return arrows[arrow_index[node_in*nodes+node_out]].label;}
+	int node_with_less_unlabeled_incoming_arrows() const {
+		int result=NO_NODE;
+		for (int node=0;node<nodes;++node)
+			if (unlabeled_incoming_arrows[node] && (result==NO_NODE || unlabeled_incoming_arrows[node]<unlabeled_incoming_arrows[result])) result=node;
+		return result;
+	}
+	//the double incoming arrows at a node h are determined when the arrows pointing to h and to the nodes with an arrow to h are all labeled.
+	//Labeling the last arrow pointing to node can only determine the double incoming arrows at node and at the nodes it points to, so only those are checked
+	bool satisfies_formal_jacobi_at_nodes_determined_by(int node) const;
+	void label_remaining_arrows() {
+		int node=node_with_less_unlabeled_incoming_arrows();
+		if (node==NO_NODE) {
+			result.push_back(tree.with_arrows(arrows));
+			return;
+		}
+		vector<int> unlabeled_arrows;
+		for (auto& arrow: arrows) 
+			if (arrow.node_out==node && !arrow.has_label()) unlabeled_arrows.push_back(arrow.node_in);	
+		int from_1=unlabeled_arrows[0];
+		for (int i=1;i<unlabeled_arrows.size();++i) {
+			int from_2=unlabeled_arrows[i];
+			if (brackets[from_1]>>from_2 & 1) continue;
+			auto brackets_from_1=brackets[from_1], brackets_from_2=brackets[from_2];
+			arrow(from_1,node).label=from_2;
+			arrow(from_2,node).label=from_1;
+			brackets[from_1]|=uint64_t{1}<<from_2;
+			brackets[from_2]|=uint64_t{1}<<from_1;
+			unlabeled_incoming_arrows[node]-=2;
+			if (!only_nice || satisfies_formal_jacobi_at_nodes_determined_by(node)) label_remaining_arrows();
+			unlabeled_incoming_arrows[node]+=2;
+			brackets[from_1]=brackets_from_1;
+			brackets[from_2]=brackets_from_2;
+			arrow(from_1,node).remove_label();
+			arrow(from_2,node).remove_label();
+		}
+	}
+public:
+	Labeler(const LabeledTree& tree, bool only_nice) : tree{tree}, nodes{tree.number_of_nodes()}, arrows{tree.arrows().begin(),tree.arrows().end()}, 
+		arrow_index(nodes*nodes,NO_NODE), unlabeled_incoming_arrows(nodes), brackets(nodes), only_nice{only_nice} {
+		assert(nodes<=numeric_limits<uint64_t>::digits);
+		for (int i=0;i<arrows.size();++i) {
+			auto& arrow=arrows[i];
+			if (arrow_index[arrow.node_in*nodes+arrow.node_out]==NO_NODE) arrow_index[arrow.node_in*nodes+arrow.node_out]=i;
+			if (arrow.has_label()) brackets[arrow.node_in]|=uint64_t{1}<<arrow.label;
+			else ++unlabeled_incoming_arrows[arrow.node_out];
+		}
+	}
+	list<LabeledTree> labelings() && {
+		label_remaining_arrows();
+		return move(result);
+	}
+};
+
+bool Labeler::satisfies_formal_jacobi_at_nodes_determined_by(int node) const {
+	if (unlabeled_incoming_arrows[node]) return true;
+	auto determined = [this] (int h) {
+		if (unlabeled_incoming_arrows[h]) return false;
+		for (int c=0;c<nodes;++c)
+			if (has_arrow(c,h) && unlabeled_incoming_arrows[c]) return false;
+		return true;
+	};
+	auto satisfies_formal_jacobi_at = [this] (int h) {
+		vector<int> double_incoming_arrows;		//packed triplets, with repetitions
+		for (int c=0;c<nodes;++c) {
+			if (!has_arrow(c,h)) continue;
+			int d=label(c,h);		//the weight {c,d}->h
+			for (int b=0;b<nodes;++b) {
+				if (!has_arrow(b,c)) continue;
+				int a=label(b,c);		//the weight {a,b}->c, counted once
+				if (b>a) continue;
+				Triplet double_arrow{a,b,d};
+				if (!double_arrow.has_repetition()) double_incoming_arrows.push_back(double_arrow.packed());
+			}
+		}
+		sort(double_incoming_arrows.begin(),double_incoming_arrows.end());
+		for (auto i=double_incoming_arrows.begin();i!=double_incoming_arrows.end();) {
+			auto next=upper_bound(i,double_incoming_arrows.end(),*i);
+			if (next-i==1) return false;
+			i=next;
+		}
+		return true;
+	};
+	for (int h=0;h<nodes;++h)
+		if ((h==node || has_arrow(node,h)) && determined(h) && !satisfies_formal_jacobi_at(h)) return false;
+	return true;
+}
+
+list<LabeledTree> LabeledTree::labelings() const  {
+	return Labeler{*this,false}.labelings();
+}
+
+list<LabeledTree> LabeledTree::nice_labelings() const  {
+	return Labeler{*this,true}.labelings();
+}
+
 bool satisfies_formal_jacobi(const LabeledTree& tree) {
 	return DoubleIncomingArrows{tree}.formal_jacobi();	
 }
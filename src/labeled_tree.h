@@ -67,6 +67,8 @@ public:
 	LabeledTree(const Tree& tree);
 	LabeledTree(const LabeledTree& labeled_tree);
 	list<LabeledTree> labelings() const;
+	//the labelings that satisfy the formal Jacobi condition, in the same order as labelings(); partial labelings that violate it are not explored further
+	list<LabeledTree> nice_labelings() const;
 	list<Weight> weights() const {
 		list<Weight> result;
 		for (auto arrow : arrows()) 
@@ -83,11 +85,10 @@ public:
 private:
 	friend struct TestLabeledTree;
 	friend class WeightedTree;
+	friend class Labeler;
 
   mutable unique_ptr<WeightBasisAndProperties> weight_basis_;
-	LabeledTree with_added_label(int to_node, int from_1, int from_2) const;
-	list<LabeledTree> labelings_with_bracket(int to_node, int from_1, int from_2) const;
-  list<LabeledTree> labelings_with_hint(int hint_node) const;
+	LabeledTree with_arrows(const vector<LabeledArrow>& labeled_arrows) const;	//same nodes, with the arrows relabeled
 	vector<int> unlabeled_arrows_pointing_to(int node) const;
   vector<int> number_of_unlabeled_incoming_arrows() const;
 	int node_with_less_unlabeled_incoming_arrows() const;
@@ -43,9 +43,139 @@ T transform_accumulate(iter_begin begin, iter_end end, T value, Closure&& closur
 	return value;
 }
 
+/* Fourier-Motzkin elimination for a system of strict inequalities a_1x_1+...+a_nx_n+b>0 with integer coefficients.
+  Each inequality is stored as the vector (a_1,...,a_n,b), divided by the gcd of its entries; the combinations of more than k+1 original inequalities
+  after k eliminations are removed, since they are redundant by Chernikov's rule. Duplicates are only removed when there are too many inequalities to apply the rule.
+  The entries are stored in 64 bits; when an entry overflows, has_solution() returns indeterminate.
+*/
+class IntegerFourierMotzkin {
+	struct Inequality {
+		vector<int64_t> coefficients;	//the constant term comes last
+		uint64_t history;					//the original inequalities this is a positive combination of
+		bool operator<(const Inequality& other) const {return coefficients<other.coefficients;}
+	};
+	int unknowns;
+	vector<Inequality> inequalities;
+	bool track_history;
+	int eliminated=0;
+	static int64_t gcd(int64_t a, int64_t b) {
+		while (b) {auto r=a%b; a=b; b=r;}
+		return a<0? -a : a;
+	}
+	static bool normalize(vector<__int128>& entries, vector<int64_t>& result) {
+		int64_t divisor=0;
+		for (auto& x: entries) {
+			if (x>numeric_limits<int64_t>::max() || x<-numeric_limits<int64_t>::max()) return false;
+			divisor=gcd(divisor,x);
+		}
+		result.resize(entries.size());
+		for (int i=0;i<entries.size();++i) result[i]=divisor? static_cast<int64_t>(entries[i])/divisor : 0;
+		return true;
+	}
+	bool is_constant(const Inequality& inequality) const {
+		return all_of(inequality.coefficients.begin(),inequality.coefficients.begin()+unknowns,[] (int64_t x) {return x==0;});
+	}
+	//removes inequalities not depending on the unknowns; returns false if one of them is not satisfied
+	bool remove_constant_inequalities() {
+		for (auto& inequality : inequalities)
+			if (is_constant(inequality) && inequality.coefficients[unknowns]<=0) return false;
+		inequalities.erase(remove_if(inequalities.begin(),inequalities.end(),[this] (auto& inequality) {return is_constant(inequality);}),inequalities.end());
+		return true;
+	}
+	//the unknown that produces the least inequalities when eliminated
+	int unknown_to_eliminate() const {
+		int best=-1;
+		long best_cost=0;
+		for (int j=0;j<unknowns;++j) {
+			long positive=0, negative=0;
+			for (auto& inequality: inequalities) {
+				if (inequality.coefficients[j]>0) ++positive;
+				else if (inequality.coefficients[j]<0) ++negative;
+			}
+			if (!positive && !negative) continue;
+			long cost=positive*negative-positive-negative;
+			if (best<0 || cost<best_cost) {best=j; best_cost=cost;}
+		}
+		return best;
+	}
+	bool eliminate(int x) {
+		vector<Inequality> positive, negative, result;
+		for (auto& inequality: inequalities) {
+			auto coeff=inequality.coefficients[x];
+			if (coeff>0) positive.push_back(inequality);
+			else if (coeff<0) negative.push_back(inequality);
+			else result.push_back(inequality);
+		}
+		++eliminated;
+		vector<__int128> combination(unknowns+1);
+		for (auto& p: positive)
+		for (auto& n: negative) {
+			uint64_t history=p.history | n.history;
+			if (track_history && __builtin_popcountll(history)>eliminated+1) continue;
+			__int128 a=p.coefficients[x], c=-n.coefficients[x];
+			for (int j=0;j<=unknowns;++j) combination[j]=c*p.coefficients[j]+a*n.coefficients[j];
+			Inequality inequality{{},history};
+			if (!normalize(combination,inequality.coefficients)) return false;
+			result.push_back(move(inequality));
+		}
+		//a duplicate may carry a history that Chernikov's rule needs later, so duplicates are only removed when histories are not tracked
+		if (!track_history) {
+			sort(result.begin(),result.end());
+			result.erase(unique(result.begin(),result.end(),[] (auto& a, auto& b) {return a.coefficients==b.coefficients;}),result.end());
+		}
+		inequalities=move(result);
+		return true;
+	}
+public:
+	//each row contains the coefficients of the unknowns, followed by the constant term
+	IntegerFourierMotzkin(int unknowns, const vector<vector<int64_t>>& rows) : unknowns{unknowns}, track_history{rows.size()<=64} {
+		for (int i=0;i<rows.size();++i)
+			inequalities.push_back({rows[i],track_history? uint64_t{1}<<i : 0});
+	}
+	tribool has_solution() && {
+		while (true) {
+			if (!remove_constant_inequalities()) return false;
+			if (inequalities.empty()) return true;
+			if (!eliminate(unknown_to_eliminate())) return indeterminate;
+		}
+	}
+};
+
 class LinearInequalities {
 	list<ex> inequalities;
 	list<ex> unknowns;
+	static bool& use_exact_arithmetic() {
+		static bool use_exact_arithmetic=true;
+		return use_exact_arithmetic;
+	}
+	//the coefficients of the unknowns and the constant term of each inequality, made integer; nullopt if the inequalities are not linear with rational coefficients
+	optional<vector<vector<int64_t>>> integer_coefficients() const {
+		vector<vector<int64_t>> result;
+		for (auto inequality : inequalities) {
+			inequality=inequality.expand();
+			vector<numeric> row;
+			ex constant_term=inequality;
+			for (auto unknown : unknowns) {
+				ex coeff=inequality.coeff(unknown);
+				if (!is_a<numeric>(coeff) || !ex_to<numeric>(coeff).is_rational()) return nullopt;
+				row.push_back(ex_to<numeric>(coeff));
+				constant_term-=coeff*unknown;
+			}
+			constant_term=constant_term.expand();
+			if (!is_a<numeric>(constant_term) || !ex_to<numeric>(constant_term).is_rational()) return nullopt;
+			row.push_back(ex_to<numeric>(constant_term));
+			numeric denominator=1;
+			for (auto& x : row) denominator=lcm(denominator,x.denom());
+			vector<int64_t> integer_row;
+			for (auto& x : row) {
+				numeric integer=x*denominator;
+				if (abs(integer).compare(numeric{numeric_limits<long>::max()})>0) return nullopt;
+				integer_row.push_back(integer.to_long());
+			}
+			result.push_back(move(integer_row));
+		}
+		return result;
+	}
 	int count_occurrences(ex variable) const {
 		return transform_accumulate(inequalities.begin(),inequalities.end(),0,[variable] (ex inequality) {
 			exset found;
@@ -93,8 +223,16 @@ public:
 		GetSymbols<Variable>(unknowns,begin,end);
 	}
 
+	//selects whether systems that are linear with rational coefficients are solved with integer arithmetic (the default) rather than symbolically
+	static void set_exact_arithmetic(bool exact) {use_exact_arithmetic()=exact;}
+
 	//applies the Fourier-Motzkin algorithm to determine whether the inequalities have a common solution
 	bool has_solution() && {
+		if (use_exact_arithmetic())
+			if (auto rows=integer_coefficients()) {
+				tribool result=IntegerFourierMotzkin{static_cast<int>(unknowns.size()),*rows}.has_solution();
+				if (!indeterminate(result)) return static_cast<bool>(result);
+			}
 		if (!remove_constant_inequalities()) return false;
 		while (!inequalities.empty()) {
 			if (!remove_constant_inequalities()) return false;
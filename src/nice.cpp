@@ -26,6 +26,7 @@
 #include <boost/exception/diagnostic_information.hpp> 
 #include "diagramprocessor.h"
 #include "partitionprocessor.h"
+#include "linearinequalities.h"
 
 
 namespace po = boost::program_options;
@@ -179,6 +180,10 @@ ProcessorCreator with_options(const po::variables_map& command_line_variables,Di
     if (command_line_variables.count("do-not-use-automorphisms")) diagram_processor.set(DiagramDataOption::do_not_use_automorphisms_to_eliminate_signs);
     if (command_line_variables.count("legacy-weight-order")) diagram_processor.set(ProcessingOption::do_not_reorder);
 		if (command_line_variables.count("sign-configuration-limit")) diagram_processor.set_sign_configuration_limit(command_line_variables["sign-configuration-limit"].as<int>());
+		if (command_line_variables.count("partition-threads")) diagram_processor.set_partition_threads(command_line_variables["partition-threads"].as<int>());
+		if (command_line_variables.count("orderly-generation")) diagram_processor.set(EnumerationOption::orderly_generation);
+		if (command_line_variables.count("symbolic-linear-inequalities")) LinearInequalities::set_exact_arithmetic(false);
+		if (command_line_variables.count("incomplete-trees-cache-limit")) set_incomplete_trees_cache_limit(command_line_variables["incomplete-trees-cache-limit"].as<int>());
     
     Filter filter;
     if (command_line_variables.count("only-traceless-derivations")) filter.only_traceless_derivations();
@@ -266,6 +271,10 @@ int main(int argc, char* argv[]) {
             ("do-not-use-automorphisms", "do not compute diagram automorphisms in order to eliminate equivalent families associated to the same diagram; may result in redundant output")
             ("invert",  "invert node numbering") 
             ("parallel-mode",  "use multiple threads") 
+            ("partition-threads", po::value<int>(), "number of threads used to generate the nice diagrams of each partition [default: 1]")
+            ("orderly-generation", "generate one way of adding each layer of nodes for each orbit under the automorphism group of the tree, rather than generating all trees and removing equivalent ones afterwards")
+            ("symbolic-linear-inequalities", "solve systems of linear inequalities by symbolic Fourier-Motzkin elimination even when the coefficients are rational numbers")
+            ("incomplete-trees-cache-limit", po::value<int>(), "number of incomplete trees kept for reuse by partitions with a common suffix [default: 262144]")
             ("matrix-data",  "include data depending on the root matrix (rank, etc.)") 
             ("derivations",  "include Lie algebra derivations in output") 
             ("diagonal-ricci-flat-metrics", "include diagonal Ricci-flat metrics")
@@ -40,9 +40,9 @@ public:
 		 }		
 		return NiceDiagramsInPartition{partition,move(trees)};
 	}
-	static NiceDiagramsInPartition compute(const vector<int>& partition, Filter filter={}) {
+	static NiceDiagramsInPartition compute(const vector<int>& partition, Filter filter={}, EnumerationOptions enumeration_options={}) {
 		int count=0;
-		auto diagrams = nice_diagrams(partition,filter,{});
+		auto diagrams = nice_diagrams(partition,filter,{},enumeration_options);
 		if (!diagrams.empty()) 
 			for (auto& diagram: diagrams)
 			  diagram.add_number_to_name(++count);
@@ -76,8 +76,8 @@ public:
 };
 
 
-NiceDiagramsInPartition nice_diagrams_in_partition(const vector<int>& partition);
+NiceDiagramsInPartition nice_diagrams_in_partition(const vector<int>& partition, EnumerationOptions enumeration_options={});
 			
-NiceDiagramsInPartition nice_diagrams_in_partition(const vector<int>& partition,Filter filter, DiagramDataOptions options);
+NiceDiagramsInPartition nice_diagrams_in_partition(const vector<int>& partition,Filter filter, DiagramDataOptions options, EnumerationOptions enumeration_options={});
 
 #endif
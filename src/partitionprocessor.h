@@ -36,7 +36,7 @@ public:
 		s<<processed.extra_data<<endl;	
 	}	
 	int process_all(ostream& s) const {
-		auto diagrams =nice_diagrams_in_partition(partition,processor.filter(),processor);
+		auto diagrams =nice_diagrams_in_partition(partition,processor.filter(),processor,processor.enumeration_options());
 		for (auto diagram : diagrams) {
 	   auto processed=process_single_diagram(diagram);
      s<<processed.data;     
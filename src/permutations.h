@@ -26,26 +26,35 @@ class PermutationsPreservingHash {
   vector<int> hash_codes_to;
   vector<int> current_permutation;
   
-  void assign(list<vector<int>>& permutations, int first_unassigned, int to) {    
+  template<typename IsCompatible, typename Visitor>
+  bool for_each_permutation(int first_unassigned, IsCompatible&& is_compatible, Visitor&& visitor) {
+    if (first_unassigned==hash_codes_from.size()) return visitor(static_cast<const vector<int>&>(current_permutation));
+    for (int to=0;to<hash_codes_to.size();++to) {
       int hash=hash_codes_to[to];
-      if (hash_codes_from[first_unassigned]==hash) {
-        hash_codes_to[to]=ASSIGNED;
-        current_permutation[first_unassigned]=to;
-        permutations.splice(permutations.end(),all_permutations(first_unassigned+1));        
-        hash_codes_to[to]=hash;
-      }  
-  }
-  list<vector<int>> all_permutations(int first_unassigned) {
-    if (first_unassigned==hash_codes_from.size()) return {current_permutation};
-    list<vector<int>> result;
-    for (int assigned_to=0;assigned_to<hash_codes_to.size();++assigned_to) 
-      assign(result, first_unassigned,assigned_to);
-    return result;        
+      if (hash_codes_from[first_unassigned]!=hash) continue;
+      current_permutation[first_unassigned]=to;
+      if (!is_compatible(static_cast<const vector<int>&>(current_permutation),first_unassigned)) continue;
+      hash_codes_to[to]=ASSIGNED;
+      bool stop=for_each_permutation(first_unassigned+1,is_compatible,visitor);
+      hash_codes_to[to]=hash;
+      if (stop) return true;
+    }
+    return false;
   }
 public:
   PermutationsPreservingHash(const vector<int>& from, const vector<int>& to) : hash_codes_from(from), hash_codes_to(to),current_permutation(from.size()) {}
+  //calls visitor on each permutation in lexicographic order, until visitor returns true. 
+  //is_compatible(sigma,i) is called when sigma(0),...,sigma(i) have been assigned; if it returns false, all permutations extending sigma(0),...,sigma(i) are skipped.
+  //returns true if the enumeration was stopped by the visitor
+  template<typename IsCompatible, typename Visitor>
+  bool for_each_permutation(IsCompatible&& is_compatible, Visitor&& visitor) {
+    return for_each_permutation(0,is_compatible,visitor);
+  }
   list<vector<int>> all_permutations() {
-    return all_permutations(0);
+    list<vector<int>> result;
+    for_each_permutation([] (const vector<int>&, int) {return true;},
+      [&result] (const vector<int>& sigma) {result.push_back(sigma); return false;});
+    return result;
   }
   static vector<int> trivial_permutation(int dimension) {
     vector<int> result(dimension);
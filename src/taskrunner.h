@@ -19,6 +19,7 @@
 #define TASKRUNNER_H
 
 #include <future>
+#include <atomic>
 using std::future;
 
 class TaskWithFileOutput {
@@ -78,4 +79,22 @@ public:
   }
 };
 
+//invokes task(0),...,task(tasks-1) using the indicated number of threads. Indices are handed out one at a time, so threads that complete their tasks early keep taking over the remaining ones 
+template<typename Task>
+void run_in_parallel(int tasks, int threads, Task&& task) {
+  if (threads<=1) {
+    for (int i=0;i<tasks;++i) task(i);
+    return;
+  }
+  std::atomic<int> next_task{0};
+  auto run_tasks = [&next_task,&task,tasks] () {
+    for (int i=next_task++;i<tasks;i=next_task++) task(i);
+  };
+  vector<future<void>> handles;
+  for (int i=0;i<threads && i<tasks;++i)
+    handles.push_back(std::async(std::launch::async,run_tasks));
+  for (auto& handle : handles)
+    handle.get();
+}
+
 #endif
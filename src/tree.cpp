@@ -17,6 +17,8 @@
 */
 #include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <tuple>
 #include <ginac/ginac.h>
 #include "tree.h"
 #include "permutations.h"
@@ -50,6 +52,14 @@ ListOfArrows& ListOfArrows::operator++() {
     return *this;
 }
 
+uint64_t ListOfArrows::bitmask() const {
+	assert(size()<=numeric_limits<uint64_t>::digits);
+	uint64_t result=0;
+	for (int i=0;i<size();++i)
+		if (at(i)) result|=uint64_t{1}<<i;
+	return result;
+}
+
 ListOfArrows::ListOfArrowsConstIterator& ListOfArrows::ListOfArrowsConstIterator::operator++() {
   while (!list_of_arrows.at(++index) && index<list_of_arrows.size());
   return *this;
@@ -57,35 +67,30 @@ ListOfArrows::ListOfArrowsConstIterator& ListOfArrows::ListOfArrowsConstIterator
 
 
 
-template<typename Closure>
-list<Tree> add_one_or_more_nodes(const Tree& tree, int nodes, ListOfArrows first_list_of_arrows, Closure&& is_valid_tree);
-
-template<typename Closure>
-list<Tree> add_nodes(const Tree& tree, int nodes,  const ListOfArrows&  first_list_of_arrows,  Closure&& is_valid_tree) {
-	if (nodes==0) return is_valid_tree(tree)? list<Tree>{tree} : list<Tree>{} ;
-  else return add_one_or_more_nodes(tree,nodes, first_list_of_arrows,std::forward<Closure>(is_valid_tree));
+template<typename Closure, typename LayerFilter>
+list<Tree> add_nodes(const Tree& tree, int nodes,  const ListOfArrows&  first_list_of_arrows,  Closure&& may_add_node, LayerFilter&& is_new_layer) {
+	list<Tree> result;
+	vector<uint64_t> layer;
+	tree_impl::for_each_way_to_add_nodes(tree,nodes,first_list_of_arrows,layer,std::forward<Closure>(may_add_node),std::forward<LayerFilter>(is_new_layer),
+		[&result] (const Tree& tree) {result.push_back(tree);}
+	);
+	return result;
 }
 
-template<typename Closure>
-list<Tree> add_one_or_more_nodes(const Tree& tree, int nodes,  ListOfArrows first_list_of_arrows,  Closure&& is_valid_tree) {
-	  list<Tree> result;
-  	while (!first_list_of_arrows.is_this_the_end()) {
-	  	auto enlarged_tree=tree; 
-	  	enlarged_tree.add_node_with_arrows(first_list_of_arrows);
-	  	result.splice(result.end(), add_nodes(enlarged_tree,nodes-1,first_list_of_arrows,std::forward<Closure>(is_valid_tree)));
-		  ++first_list_of_arrows;
-	  }
-	  return result;
+list<Tree> WaysToAddANode::add_intermediate_nodes(const Tree& tree, int nodes) {
+  auto may_add_node = [] (const Tree& tree, const ListOfArrows& destinations, int remaining_nodes) {return tree.may_be_enlarged_by_adding(destinations,remaining_nodes);};
+  return add_nodes(tree,nodes,first(),may_add_node,tree_impl::every_layer);
 }
 
-list<Tree> WaysToAddANode::add_intermediate_nodes(const Tree& tree, int nodes) {
-  auto is_valid_tree =  [nodes] (const Tree& tree) {return tree.is_valid_enlargement_by(nodes);};
-  return add_nodes(tree,nodes,first(),is_valid_tree);
+list<Tree> WaysToAddANode::add_intermediate_nodes_up_to_automorphisms(const Tree& tree, int nodes) {
+  auto may_add_node = [] (const Tree& tree, const ListOfArrows& destinations, int remaining_nodes) {return tree.may_be_enlarged_by_adding(destinations,remaining_nodes);};
+  LayersUpToAutomorphisms layers{tree};
+  return add_nodes(tree,nodes,first(),may_add_node,[&layers] (const vector<uint64_t>& layer) {return layers.is_new(layer);});
 }
 
 list<Tree> WaysToAddANode::add_last_nodes(const Tree& tree, int nodes) {
-  auto is_valid_tree =  [nodes] (const Tree& tree) {return tree.is_valid_completion_by(nodes);};
-  return add_nodes(tree,nodes,first(),is_valid_tree);
+  auto may_add_node = [] (const Tree& tree, const ListOfArrows& destinations, int remaining_nodes) {return tree.may_be_completed_by_adding(destinations,remaining_nodes);};
+  return add_nodes(tree,nodes,first(),may_add_node,tree_impl::every_layer);
 }
 
 ostream& operator<<(ostream& os, const WaysToAddANode& ways) {
@@ -106,37 +111,20 @@ template<typename T> bool is_permutation_of(vector<T> v, vector<T> w) {
 }
 
 
-bool Tree::is_valid_enlargement_by(int nodes, bool verbose) const {
-		if( verbose) {
-			cout<<"checking validity of "<<endl; 
-			cout<<*this;
-			cout<<"nodes "<<nodes<<endl;
-		}
-		//check that all the original nodes have an incoming arrow.
-		for (int i=0;i<no_nodes-nodes;++i)
-			if (incoming_arrows[i]==0) {
-				if (verbose) cout<<"not valid"<<endl;	
-				return false;
-			}
-		if (verbose) cout<<"valid"<<endl;
+//each node added after the current one gives at most one incoming arrow to each of the original nodes
+bool Tree::may_be_enlarged_by_adding(const ListOfArrows& destinations, int remaining_nodes) const {
+		if (remaining_nodes>0) return true;
+		for (int i=0;i<destinations.size();++i)
+			if (incoming_arrows[i]+destinations.at(i)==0) return false;
 		return true;
 	}
 
-bool Tree::is_valid_completion_by(int nodes, bool verbose) const {
-		if( verbose) {
-			cout<<"checking validity of "<<endl; 
-			cout<<*this;
-			cout<<"nodes "<<nodes<<endl;
+bool Tree::may_be_completed_by_adding(const ListOfArrows& destinations, int remaining_nodes) const {
+		if (remaining_nodes>1) return true;
+		for (int i=0;i<destinations.size();++i) {
+			auto incoming_arrows_at_node=incoming_arrows[i]+destinations.at(i);
+			if (incoming_arrows_at_node==0 || (remaining_nodes==0 && incoming_arrows_at_node%2)) return false;
 		}
-		//check that the original nodes all have an even, nonzero number of incoming arrows.
-		for (int i=0;i<no_nodes-nodes;++i) {
-			auto incoming_arrows_at_node=incoming_arrows[i] ;
-			if (incoming_arrows_at_node==0 || incoming_arrows_at_node%2) {
-				if (verbose) cout<<"not valid"<<endl;	
-				return false;
-			}
-		}
-		if (verbose) cout<<"valid"<<endl;
 		return true;
 	}
 
@@ -144,8 +132,6 @@ bool Tree::is_valid_completion_by(int nodes, bool verbose) const {
 
 
 
-
-
 list<Tree> enlarge_tree(const Tree& tree, int nodes) {
 //	for each new_node attach in all possible ways to an inner node
 //	in such a way that each inner node is attached to something
@@ -162,48 +148,123 @@ list<Tree> complete_tree(const Tree& tree, int nodes) {
 
 
 
-list<Tree> enlarge_incomplete_trees(int nodes_to_add, list<Tree>&& incomplete_trees) {
+LayersUpToAutomorphisms::LayersUpToAutomorphisms(const Tree& tree) : nodes{tree.number_of_nodes()}, generators{tree.automorphism_group_generators()} {
+	assert(nodes<=numeric_limits<uint64_t>::digits);
+}
+
+vector<uint64_t> LayersUpToAutomorphisms::image(const vector<uint64_t>& layer, const vector<int>& sigma) const {
+	vector<uint64_t> result;
+	for (auto destinations : layer) {
+		uint64_t image_of_destinations=0;
+		for (int i=0;i<nodes;++i)
+			if (destinations & uint64_t{1}<<i) image_of_destinations|=uint64_t{1}<<sigma[i];
+		result.push_back(image_of_destinations);
+	}
+	sort(result.begin(),result.end());
+	return result;
+}
+
+//layers are generated in increasing order, so the one that is kept is the first in its orbit, i.e. the one that remove_equivalent_trees would keep
+bool LayersUpToAutomorphisms::is_new(const vector<uint64_t>& layer) {
+	if (generators.empty()) return true;
+	if (!known_layers.insert(layer).second) return false;
+	list<vector<uint64_t>> orbit{layer};
+	for (auto& known_layer : orbit)
+		for (auto& sigma : generators) {
+			auto known_image=image(known_layer,sigma);
+			if (known_layers.insert(known_image).second) orbit.push_back(move(known_image));
+		}
+	return true;
+}
+
+list<Tree> enlarge_tree_up_to_automorphisms(const Tree& tree, int nodes) {
+	return tree.ways_to_add_a_node().add_intermediate_nodes_up_to_automorphisms(tree,nodes);
+}
+
+list<Tree> enlarge_incomplete_trees(int nodes_to_add, const list<Tree>& incomplete_trees, EnumerationOptions options) {
 	list<Tree> result;
 	for (auto& tree: incomplete_trees) 
-		result.splice(result.end(),enlarge_tree(tree,nodes_to_add));
+		result.splice(result.end(),options.orderly_generation()? enlarge_tree_up_to_automorphisms(tree,nodes_to_add) : enlarge_tree(tree,nodes_to_add));
 	return result;
 }
 
-list<Tree> incomplete_trees(const vector<int>& partition, int final_dimension) {
-	assert(partition.size()>0);
-	return (partition.size()==1) ?  
-	  list<Tree>{Tree{partition[0],final_dimension}} :
-	  enlarge_incomplete_trees(partition[0], incomplete_trees ({partition.begin()+1,partition.end()},final_dimension));
+//lists of incomplete trees indexed by partition, final dimension and orderly generation; when the total number of trees exceeds the limit, the least recently used lists are discarded.
+//Cached trees are shared between threads, so their cached data must be computed before they are inserted; then they are only read
+class IncompleteTreesCache {
+	using Key=std::tuple<vector<int>,int,bool>;
+	struct Entry {
+		std::shared_ptr<const list<Tree>> trees;
+		long last_used;
+	};
+	std::mutex mutex;
+	map<Key,Entry> entries;
+	long uses=0;
+	size_t cached_trees=0;
+	size_t max_trees=1<<18;
+	void remove_least_recently_used() {
+		auto oldest=min_element(entries.begin(),entries.end(),[] (auto& entry1, auto& entry2) {return entry1.second.last_used<entry2.second.last_used;});
+		cached_trees-=oldest->second.trees->size();
+		entries.erase(oldest);
+	}
+public:
+	std::shared_ptr<const list<Tree>> find(const Key& key) {
+		std::lock_guard<std::mutex> lock{mutex};
+		auto i=entries.find(key);
+		if (i==entries.end()) return nullptr;
+		i->second.last_used=++uses;
+		return i->second.trees;
+	}
+	void insert(const Key& key, std::shared_ptr<const list<Tree>> trees) {
+		std::lock_guard<std::mutex> lock{mutex};
+		if (trees->size()>max_trees || !entries.emplace(key,Entry{trees,++uses}).second) return;
+		cached_trees+=trees->size();
+		while (cached_trees>max_trees) remove_least_recently_used();
+	}
+	void set_limit(int trees) {
+		std::lock_guard<std::mutex> lock{mutex};
+		max_trees=trees;
+		while (cached_trees>max_trees) remove_least_recently_used();
+	}
+};
+
+IncompleteTreesCache& incomplete_trees_cache() {
+	static IncompleteTreesCache cache;
+	return cache;
 }
 
-list<Tree> complete_incomplete_trees(int nodes_to_add, list<Tree>&& incomplete_trees) {
-	list<Tree> result;
-	nice_log<<incomplete_trees.size()<<"trees to complete"<<endl;
-	remove_equivalent_trees(incomplete_trees);  //apparently useless (??)
-	nice_log<<incomplete_trees.size()<<"trees to complete after removal of equivalents"<<endl;
-  auto counter= nice_log.counter("completing tree",100);
-	for (auto&& tree: move(incomplete_trees)) {
-  	  nice_log<<counter;
-  	  auto completions=complete_tree(tree,nodes_to_add);
-  	  //nice_log<<completions.size()<<" completions"<<endl;
-	  	result.splice(result.end(),completions);
-  }
+void set_incomplete_trees_cache_limit(int trees) {
+	incomplete_trees_cache().set_limit(trees);
+}
+
+std::shared_ptr<const list<Tree>> cached_incomplete_trees(const vector<int>& partition, int final_dimension, EnumerationOptions options) {
+	assert(partition.size()>0);
+	if (partition.size()==1) return std::make_shared<const list<Tree>>(list<Tree>{Tree{partition[0],final_dimension}});
+	std::tuple<vector<int>,int,bool> key{partition,final_dimension,options.orderly_generation()};
+	auto result=incomplete_trees_cache().find(key);
+	if (result) return result;
+	auto trees=enlarge_incomplete_trees(partition[0], *cached_incomplete_trees({partition.begin()+1,partition.end()},final_dimension,options),options);
+	for (auto& tree : trees) tree.compute_cached_data();
+	result=std::make_shared<const list<Tree>>(move(trees));
+	incomplete_trees_cache().insert(key,result);
 	return result;
 }
 
-list<Tree> trees(vector<int> partition) {
+list<Tree> incomplete_trees(const vector<int>& partition, int final_dimension, EnumerationOptions options) {
+	return *cached_incomplete_trees(partition,final_dimension,options);
+}
+
+list<Tree> trees_to_complete(const vector<int>& partition, EnumerationOptions options) {
 	assert(partition.size()>0);
-	string label=get_label(partition);
-	nice_log<<"computing trees with partition "<<label<<endl;
 	int dimension=accumulate(partition.begin(),partition.end(),0);
-	list<Tree> result = (partition.size()==1) ? 
-	  list<Tree>{Tree{partition[0],dimension}} : 
-	  complete_incomplete_trees(partition[0],incomplete_trees({partition.begin()+1,partition.end()},dimension));
+	if (partition.size()==1) return {Tree{0,dimension}};
+	auto result=incomplete_trees({partition.begin()+1,partition.end()},dimension,options);
 	remove_equivalent_trees(result);
-//	for (auto& tree : result)	tree.set_name(label);
 	return result;
 }
 
-
-
-
+list<Tree> trees(vector<int> partition) {
+	list<Tree> result;
+	for_each_tree(partition,[&result] (const Tree& tree) {result.push_back(tree);});
+	result.sort([] (const Tree& tree1, const Tree& tree2) {return tree1.hash()<tree2.hash();});
+	return result;
+}
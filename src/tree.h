@@ -22,6 +22,7 @@
 #include "permutations.h"
 #include "log.h"
 #include "horizontal.h"
+#include "options.h"
 
 
 class Tree;
@@ -56,6 +57,7 @@ public:
   bool is_this_the_end() const {return arrow_present.back();}
   bool at(int index) const {return arrow_present[index];}
   int size() const {return arrow_present.size()-1;}
+  uint64_t bitmask() const;	//bit i is set if there is an arrow to node i; lists are enumerated in increasing order of bitmask
   bool operator!=(const ListOfArrows& list_of_arrows) {return arrow_present!=list_of_arrows.arrow_present;}
 private:
 //contains one extra element which is set to true to represent the list_of_arrows "past the end" when iterating through lists of arrows
@@ -68,7 +70,10 @@ class WaysToAddANode {
 public:
   WaysToAddANode(int number_of_nodes) : nodes{number_of_nodes} {}
 	list<Tree> add_intermediate_nodes(const Tree& tree, int nodes);
+	list<Tree> add_intermediate_nodes_up_to_automorphisms(const Tree& tree, int nodes);
 	list<Tree> add_last_nodes(const Tree& tree, int nodes);
+	template<typename Visitor> void for_each_way_to_add_last_nodes(const Tree& tree, int nodes, Visitor&& visitor) const;
+	template<typename Visitor> void for_each_way_to_add_last_nodes_up_to_automorphisms(const Tree& tree, int nodes, Visitor&& visitor) const;
 	ListOfArrows first() const {return ListOfArrows{nodes,Position::begin};}
 private:
   int nodes;
@@ -76,19 +81,22 @@ private:
 
 ostream& operator<<(ostream& os, const WaysToAddANode& ways);
 
-class FixedLengthVectorInt : private vector<int> {
+template<typename T>
+class FixedLengthVector : private vector<T> {
 public:
-  using vector<int>::vector;
-  using vector<int>::operator[];
-  vector<int> to_vector(int size) const {return {begin(),begin()+size};}
+  using vector<T>::vector;
+  using vector<T>::operator[];
+  vector<T> to_vector(int size) const {return {vector<T>::begin(),vector<T>::begin()+size};}
   bool has_at_least_capacity(int size) const {
-    return vector<int>::size()>=size;
+    return vector<T>::size()>=size;
   }
 };
 
+using FixedLengthVectorInt = FixedLengthVector<int>;
+
 class SetOfNodes {
 public:
-	SetOfNodes(int nodes, int final_size) : no_nodes{nodes},  nodes_hash(final_size) {}
+	SetOfNodes(int nodes, int final_size) : no_nodes{nodes},  nodes_hash(final_size), nodes_invariant(final_size) {}
 	SetOfNodes()=default;
 	string name() const {
 	  if (name_.empty()) return std::to_string(number_)+ "#"+std::to_string(tree_hash);
@@ -106,6 +114,9 @@ protected:
 	int no_nodes=0;
 	mutable int tree_hash=HASH_NOT_COMPUTED;
 	mutable FixedLengthVectorInt nodes_hash;
+	//64-bit invariants computed together with the hash; unlike the hash, which is used to name diagrams, they are not subject to overflow
+	mutable uint64_t tree_invariant=0;
+	mutable FixedLengthVector<uint64_t> nodes_invariant;
 	bool capacity_exceeded() {return !nodes_hash.has_at_least_capacity(no_nodes);}
 private:
   int number_=0;
@@ -116,11 +127,25 @@ private:
 template<typename ArrowType> class TreeBase : public SetOfNodes {
 private:
 	list<ArrowType> arrows_in_tree;
+	//the arrows in bitmask form, computed on demand: bit j of outgoing[i] (resp. incoming[j]) is set if there is an arrow i->j;
+	//for labeled arrows, labels[i*n+j] is the label of i->j and targets[i*n+k] is the first j such that i->j has label k, or NO_NODE
+	struct Adjacency {
+		vector<uint64_t> outgoing, incoming;
+		vector<int> labels, targets;
+	};
+	mutable Adjacency adjacency_;
+	const Adjacency& adjacency() const;
+	void compute_hash_and_cache_result(const vector<int>& topological_order) const;	//path counts by dynamic programming along the order
 	void compute_hash_and_cache_result_ordered() const;	//assumes arrows have the form i-> j with i>j
 protected:
-	static const int NO_NODE=-1;
-	void invalidate() {tree_hash=HASH_NOT_COMPUTED;}
+	static constexpr int NO_NODE=-1;
+	void invalidate() {
+		tree_hash=HASH_NOT_COMPUTED;
+		adjacency_.outgoing.clear();
+	}
 	bool matches(const TreeBase& tree, const vector<int>& permutation) const;
+	//necessary condition for matches, where permutation is only defined on the nodes up to node: arrows between node and the previous nodes are preserved
+	bool matches_on_first_nodes(const TreeBase& tree, const vector<int>& permutation, int node) const;
   void add_arrow(const ArrowType& arrow) {
     arrows_in_tree.push_back(arrow);
 		invalidate();
@@ -142,7 +167,15 @@ public:
 	TreeBase() = default;
 	using SetOfNodes::SetOfNodes;
   const list<ArrowType>& arrows() const {return arrows_in_tree;} 
+	bool has_arrow(int node_in, int node_out) const {return adjacency().outgoing[node_in]>>node_out & 1;}
+	bool contains(const ArrowType& arrow) const;
+	uint64_t outgoing_nodes(int node) const {return adjacency().outgoing[node];}
+	uint64_t incoming_nodes(int node) const {return adjacency().incoming[node];}
+	int label(int node_in, int node_out) const {return adjacency().labels[node_in*number_of_nodes()+node_out];}	//NO_NODE if there is no labeled arrow node_in->node_out
+	int node_out(int node_in, int label) const {return adjacency().targets[node_in*number_of_nodes()+label];}	//NO_NODE if there is no arrow from node_in with this label
 	bool is_equivalent_to(const TreeBase& tree) const;
+	pair<int,string> canonical_certificate() const;	//equal for two trees if and only if they are equivalent
+	list<vector<int>> automorphism_group_generators() const;	//generators of the automorphism group, found while computing the canonical certificate
 	list<vector<int>> nontrivial_automorphisms() const;
 	vector<int> node_hash() const {
 	  if (tree_hash==HASH_NOT_COMPUTED) compute_hash_and_cache_result_ordered();
@@ -152,12 +185,30 @@ public:
 	  if (tree_hash==HASH_NOT_COMPUTED) compute_hash_and_cache_result_ordered();
     return tree_hash;	  
 	}
+	vector<uint64_t> node_invariant() const {
+	  if (tree_hash==HASH_NOT_COMPUTED) compute_hash_and_cache_result_ordered();
+	  return nodes_invariant.to_vector(number_of_nodes());
+	}
+	uint64_t invariant() const {
+	  if (tree_hash==HASH_NOT_COMPUTED) compute_hash_and_cache_result_ordered();
+    return tree_invariant;
+	}
+	vector<int> node_classes() const;
+	//computes the data that is otherwise computed on demand, i.e. hash, invariants and adjacency; afterwards, const member functions only read the tree,
+	//so that it can be accessed by several threads
+	void compute_cached_data() const {
+		hash();
+		adjacency();
+	}
 	string to_dot_string(string extra_data={}) const;
 	void invert_nodes() {
-    for (int i=0;2*i<number_of_nodes();++i)
+    for (int i=0;2*i<number_of_nodes();++i) {
       swap(nodes_hash[i],nodes_hash[number_of_nodes()-1-i]);
+      swap(nodes_invariant[i],nodes_invariant[number_of_nodes()-1-i]);
+    }
 	  for (auto& arrow: arrows_in_tree)
 	    arrow.invert(number_of_nodes());	 
+	  adjacency_.outgoing.clear();
    }
   template<typename Compare> 
 	void sort_arrows(Compare&& compare) {
@@ -178,8 +229,10 @@ public:
   Tree(const Tree& tree) :  TreeBase<Arrow>(tree), incoming_arrows{tree.incoming_arrows} {}
   Tree(Tree&&)=default;
 	Tree(int nodes, int final_size) : TreeBase<Arrow>(nodes,final_size), incoming_arrows(final_size) {}
-	bool is_valid_enlargement_by(int nodes, bool verbose=false) const;
-	bool is_valid_completion_by(int nodes, bool verbose=false) const;
+	//false if adding a node with arrows towards destinations, followed by remaining_nodes more nodes with arrows towards the same original nodes,
+	//cannot give a valid enlargement (resp. completion); for remaining_nodes=0, this is the validity of the resulting tree
+	bool may_be_enlarged_by_adding(const ListOfArrows& destinations, int remaining_nodes) const;
+	bool may_be_completed_by_adding(const ListOfArrows& destinations, int remaining_nodes) const;
 	WaysToAddANode ways_to_add_a_node() const {return {no_nodes};}
 
 	void add_node_with_arrows(const ListOfArrows& destinations) {
@@ -199,6 +252,14 @@ void remove_equivalent_trees(list<Tree>& list_of_trees);
 template<typename Tree> 
 void remove_equivalent_trees_same_hash(list<Tree>& list_of_trees);
 
+//keeps one representative for each equivalence class of trees, namely the first one inserted
+template<typename Tree> 
+class InequivalentTrees {
+	set<pair<int,string>> certificates;
+public:
+	bool insert(const Tree& tree);
+};
+
 struct Weight {
 	int node_in1, node_in2, node_out;
 };
@@ -207,7 +268,46 @@ inline ostream& operator<<(ostream& os, Weight weight) {
 	return os<<"{"<<weight.node_in1+1<<","<<weight.node_in2+1<<"}->"<<weight.node_out+1;
 }
 
+enum class EnumerationOption : unsigned int {
+  dflt=0,
+  orderly_generation=1	//when adding a layer of nodes, generate one layer for each orbit under the automorphism group, and no other trees
+};
+
+//options affecting how trees and diagrams are enumerated, but not the result
+struct EnumerationOptions : Options<EnumerationOption> {
+  bool orderly_generation() const {return has(EnumerationOption::orderly_generation);}
+  int threads=1;	//number of threads used to complete and label the trees of a single partition
+};
+
+list<Tree> incomplete_trees(const vector<int>& partition, int final_dimension, EnumerationOptions options={});
+//incomplete trees are memoized, since partitions with a common suffix share the incomplete trees computed along the way; the cache can be accessed
+//by several threads, and holds at most the given number of trees, discarding the least recently used first
+void set_incomplete_trees_cache_limit(int trees);
 list<Tree> trees(vector<int> partition);
 
+//the inequivalent trees that give trees(partition) when completed by partition[0] nodes 
+list<Tree> trees_to_complete(const vector<int>& partition, EnumerationOptions options={});
+
+//keeps track of the ways of adding a layer of nodes to a tree, up to automorphisms of the tree. A layer is the sorted list of the bitmasks
+//of the destinations of the new nodes; since the new nodes are those with no incoming arrows, two enlargements are equivalent if and only if
+//their layers are in the same orbit
+class LayersUpToAutomorphisms {
+  int nodes;
+  list<vector<int>> generators;
+  set<vector<uint64_t>> known_layers;
+  vector<uint64_t> image(const vector<uint64_t>& layer, const vector<int>& sigma) const;
+public:
+  LayersUpToAutomorphisms(const Tree& tree);
+  bool is_new(const vector<uint64_t>& layer);
+};
+
+//invokes visitor on each completion of tree by the given number of nodes, up to equivalence
+template<typename Visitor>
+void for_each_completion(const Tree& tree, int nodes, Visitor&& visitor, EnumerationOptions options={});
+
+//invokes visitor on each tree of trees(partition) as soon as it is generated, without storing the list of candidate trees; the order is not sorted by hash
+template<typename Visitor>
+void for_each_tree(const vector<int>& partition, Visitor&& visitor, EnumerationOptions options={});
+
 #include "tree.hpp"
 #endif
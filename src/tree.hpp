@@ -1,4 +1,5 @@
 #include "automorphisms.h"
+#include "canonicalform.h"
 
 template<typename ArrowType>
 string TreeBase<ArrowType>::to_dot_string(string extra_data) const {
@@ -13,8 +14,24 @@ string TreeBase<ArrowType>::to_dot_string(string extra_data) const {
 
 
 namespace tree_impl {
+	//splitmix64 finalizer
+	inline uint64_t mix(uint64_t x) {
+		x+=0x9e3779b97f4a7c15ull;
+		x=(x^(x>>30))*0xbf58476d1ce4e5b9ull;
+		x=(x^(x>>27))*0x94d049bb133111ebull;
+		return x^(x>>31);
+	}
+
 	class NodePathData {
 	public:
+		//depends on all the counts, whereas hash() only retains four bits of each
+		uint64_t invariant() const {
+			uint64_t result=mix(no_outgoing_concatenated_arrows.size());
+			for (int count : no_outgoing_concatenated_arrows) result=mix(result+count);
+			result=mix(result+no_incoming_concatenated_arrows.size());
+			for (int count : no_incoming_concatenated_arrows) result=mix(result+count);
+			return result;
+		}
     int hash() const {    
     	if ((no_outgoing_concatenated_arrows.size()+no_incoming_concatenated_arrows.size()*4+2)>std::numeric_limits<unsigned>::digits)
     		nice_log<<"not enough digits in an int!: "<<no_outgoing_concatenated_arrows.size()<<" "<<no_incoming_concatenated_arrows.size()<<endl;    
@@ -31,24 +48,22 @@ namespace tree_impl {
       for (int i=0;i<no_incoming_concatenated_arrows.size();++i)
         os<<no_incoming_concatenated_arrows[i]<< " incoming concatenated arrows of length "<<i<<endl;
     }
-  protected:
-    vector<int> no_outgoing_concatenated_arrows;	//TODO reserve size?
-    vector<int> no_incoming_concatenated_arrows;
-    static void resize_if_needed(vector<int>& v, int new_size) {
-      if (v.size()<new_size) v.resize(new_size);
-    }
-	};
-
-	class NodePathDataOrdered : public NodePathData {
-	public:
-    void add_incoming_arrows(const NodePathDataOrdered& incoming_node_data) {
+    //to be called in topological order, i.e. after the nodes with arrows towards this node
+    void add_incoming_arrows(const NodePathData& incoming_node_data) {
       const vector<int>&  long_incoming_arrows= incoming_node_data.no_incoming_concatenated_arrows;
       add_long_arrows(no_incoming_concatenated_arrows,long_incoming_arrows);
     }
-    void add_outgoing_arrows(const NodePathDataOrdered& outgoing_node_data) {
+    //to be called in reverse topological order, i.e. after the nodes this node has arrows towards
+    void add_outgoing_arrows(const NodePathData& outgoing_node_data) {
       const vector<int>& long_outgoing_arrows= outgoing_node_data.no_outgoing_concatenated_arrows;
       add_long_arrows(no_outgoing_concatenated_arrows,long_outgoing_arrows);
     }
+  private:
+    vector<int> no_outgoing_concatenated_arrows;	//TODO reserve size?
+    vector<int> no_incoming_concatenated_arrows;
+    static void resize_if_needed(vector<int>& v, int new_size) {
+      if (v.size()<new_size) v.resize(new_size);
+    }
     static void add_long_arrows(vector<int>& no_concatenated_arrows, const vector<int>& no_long_concatenated_arrows) {
       resize_if_needed(no_concatenated_arrows,no_long_concatenated_arrows.size()+1);
       ++no_concatenated_arrows[0];
@@ -57,142 +72,180 @@ namespace tree_impl {
     }
 	};
 
-	class NodePathDataUnordered : public NodePathData {
-	public:
-		void add_outgoing_power_arrow(int length) {
-			resize_if_needed(no_outgoing_concatenated_arrows,length);
-			++no_outgoing_concatenated_arrows[length-1];
-		}
-		void add_incoming_power_arrow(int length) {
-			resize_if_needed(no_incoming_concatenated_arrows,length);
-			++no_incoming_concatenated_arrows[length-1];
-		}
-	};
-	
-	class Paths {
-		using Path=list<int>;
-		list<Path> paths;
-		static Path join(Path path, int node) {
-			path.push_back(node);
-			assert(path.front()!=path.back());
-			return path;
-		}
-		static Path join(int node, Path path) {
-			path.push_front(node);
-			assert(path.front()!=path.back());
-			return path;
-		}
-		static Path join(Path path1, const Path& path2) {
-			path1.insert(path1.end(),path2.begin(),path2.end());
-			assert(path1.front()!=path1.back());
-			return path1;
-		}
-	
-		template<typename ArrowType>
-		void add_arrow(ArrowType arrow) {
-			list<Path> extendable_forward, extendable_backwards;
-			for (auto path: paths)
-				if (path.front()==arrow.node_out) extendable_backwards.push_back(path);
-				else if (path.back()==arrow.node_in) extendable_forward.push_back(path);
-			for (auto& path: extendable_forward)
-				paths.push_back(join(path,arrow.node_out));
-			for (auto& path: extendable_backwards)
-				paths.push_back(join(arrow.node_in,path));
-			for (auto& path1 : extendable_forward)
-				for (auto& path2: extendable_backwards)
-					paths.push_back(join(path1,path2));
-			paths.push_back({arrow.node_in,arrow.node_out});
-		}
-		int size;	
-	public:
-		template<typename Tree>
-		Paths(const Tree& tree) : size(tree.number_of_nodes()) {
-			for (auto arrow : tree.arrows()) add_arrow(arrow);
-		}
-
-		vector<NodePathDataUnordered> node_data() const {
-			vector<NodePathDataUnordered> result{size};		
-		  for (auto& path: paths) {
-				result[path.front()].add_outgoing_power_arrow(path.size()-1);
-				result[path.back()].add_incoming_power_arrow(path.size()-1);
-		 	}
-			 return result;
-		}
-	};		
+	//orders the nodes so that each arrow goes from a node to a later node; the arrows are assumed not to form cycles
+	template<typename Arrows>
+	vector<int> topological_order(int nodes, const Arrows& arrows) {
+		vector<int> incoming_arrows(nodes);
+		for (auto& arrow : arrows) ++incoming_arrows[arrow.node_out];
+		vector<int> result;
+		for (int node=0;node<nodes;++node)
+			if (!incoming_arrows[node]) result.push_back(node);
+		for (int i=0;i<result.size();++i)
+			for (auto& arrow : arrows)
+				if (arrow.node_in==result[i] && !--incoming_arrows[arrow.node_out]) result.push_back(arrow.node_out);
+		assert(result.size()==nodes);
+		return result;
+	}
 }
 
 
 
+namespace tree_impl {
+	//numbers the distinct invariants appearing in either vector, so that equal invariants get the same number
+	inline pair<vector<int>,vector<int>> classes(const vector<uint64_t>& invariants1, const vector<uint64_t>& invariants2) {
+		vector<uint64_t> all_invariants{invariants1};
+		all_invariants.insert(all_invariants.end(),invariants2.begin(),invariants2.end());
+		sort(all_invariants.begin(),all_invariants.end());
+		auto class_of = [&all_invariants] (uint64_t invariant) -> int {
+			return lower_bound(all_invariants.begin(),all_invariants.end(),invariant)-all_invariants.begin();
+		};
+		pair<vector<int>,vector<int>> result;
+		transform(invariants1.begin(),invariants1.end(),back_inserter(result.first),class_of);
+		transform(invariants2.begin(),invariants2.end(),back_inserter(result.second),class_of);
+		return result;
+	}
+}
+
+template<typename Arrow> vector<int> TreeBase<Arrow>::node_classes() const {
+	return tree_impl::classes(node_invariant(),{}).first;
+}
+
 template<typename Arrow> bool TreeBase<Arrow>::is_equivalent_to(const TreeBase& tree) const {
-	if (hash()!=tree.hash()) return false;
+	if (hash()!=tree.hash() || invariant()!=tree.invariant()) return false;
 	if (no_nodes!=tree.no_nodes) return false;
 	if (arrows().size()!=tree.arrows().size()) return false;
-	auto permutations =PermutationsPreservingHash{node_hash(), tree.node_hash()}.all_permutations(); 
-	return any_of(permutations.begin(),permutations.end(),
-	  [&tree,this] (const vector<int>& sigma) {return matches(tree,sigma);}
-	  );
+	auto classes=tree_impl::classes(node_invariant(),tree.node_invariant());
+	return PermutationsPreservingHash{classes.first, classes.second}.for_each_permutation(
+		[&tree,this] (const vector<int>& sigma, int node) {return matches_on_first_nodes(tree,sigma,node);},
+		[&tree,this] (const vector<int>& sigma) {return matches(tree,sigma);}
+	);
+}
+
+template<typename Arrow> pair<int,string> TreeBase<Arrow>::canonical_certificate() const {
+	return {hash(),::canonical_certificate(no_nodes,arrows(),node_classes())};
+}
+
+template<typename Arrow> list<vector<int>> TreeBase<Arrow>::automorphism_group_generators() const {
+	return ::automorphism_group_generators(no_nodes,arrows(),node_classes());
 }
 
 template<typename Arrow> list<vector<int>> TreeBase<Arrow>::nontrivial_automorphisms() const {
   list<vector<int>> automorphisms;
   nice_log<<"hash = "<<horizontal(node_hash())<<endl;
-	auto permutations =PermutationsPreservingHash{node_hash(), node_hash()}.all_permutations(); 
-  copy_if(permutations.begin(),permutations.end(),back_inserter(automorphisms),
-    [this] (const vector<int>& sigma) {return matches(*this,sigma);}
-  );
+  auto classes=node_classes();
+	PermutationsPreservingHash{classes, classes}.for_each_permutation(
+		[this] (const vector<int>& sigma, int node) {return matches_on_first_nodes(*this,sigma,node);},
+		[this,&automorphisms] (const vector<int>& sigma) {
+			if (matches(*this,sigma)) automorphisms.push_back(sigma);
+			return false;
+		}
+	);
   automorphisms.remove(PermutationsPreservingHash::trivial_permutation(number_of_nodes()));
   return automorphisms;
 }
 
-//optimized specialization for labeled trees. TODO optimize also for unlabeled trees.
+//optimized specialization for labeled trees
 template<> list<vector<int>> TreeBase<LabeledArrow>::nontrivial_automorphisms() const;
 
+template<typename ArrowType> auto TreeBase<ArrowType>::adjacency() const -> const Adjacency& {
+	if (adjacency_.outgoing.size()!=no_nodes || no_nodes==0) {
+		assert(no_nodes<=numeric_limits<uint64_t>::digits);
+		adjacency_.outgoing.assign(no_nodes,0);
+		adjacency_.incoming.assign(no_nodes,0);
+		for (auto& arrow: arrows()) {
+			adjacency_.outgoing[arrow.node_in]|=uint64_t{1}<<arrow.node_out;
+			adjacency_.incoming[arrow.node_out]|=uint64_t{1}<<arrow.node_in;
+		}
+		if constexpr (!std::is_same_v<ArrowType,Arrow>) {
+			adjacency_.labels.assign(no_nodes*no_nodes,NO_NODE);
+			adjacency_.targets.assign(no_nodes*no_nodes,NO_NODE);
+			for (auto& arrow: arrows()) {
+				int label=label_of(arrow);
+				adjacency_.labels[arrow.node_in*no_nodes+arrow.node_out]=label;
+				if (label!=NO_NODE && adjacency_.targets[arrow.node_in*no_nodes+label]==NO_NODE)
+					adjacency_.targets[arrow.node_in*no_nodes+label]=arrow.node_out;
+			}
+		}
+	}
+	return adjacency_;
+}
+
+template<typename ArrowType> bool TreeBase<ArrowType>::contains(const ArrowType& arrow) const {
+	if (!has_arrow(arrow.node_in,arrow.node_out)) return false;
+	if constexpr (std::is_same_v<ArrowType,Arrow>) return true;
+	else return label(arrow.node_in,arrow.node_out)==label_of(arrow);
+}
+
+template<typename Arrow> bool TreeBase<Arrow>::matches_on_first_nodes(const TreeBase& tree, const vector<int>& permutation, int node) const {
+	for (int i=0;i<=node;++i)
+		if (has_arrow(i,node)!=tree.has_arrow(permutation[i],permutation[node]) || has_arrow(node,i)!=tree.has_arrow(permutation[node],permutation[i]))
+			return false;
+	return true;
+}
+
 template<typename Arrow> bool TreeBase<Arrow>::matches(const TreeBase& tree, const vector<int>& permutation) const {
 	for (Arrow arrow: arrows()) {
 		arrow.apply_permutation(permutation);
-		if (find(tree.arrows().begin(),tree.arrows().end(),arrow)==tree.arrows().end()) return false;
+		if (!tree.contains(arrow)) return false;
 	}
 	return true;
 }
 
 
-template<typename Arrow> void TreeBase<Arrow>::compute_hash_and_cache_result_unordered() const {
-	auto node_data=tree_impl::Paths {*this}.node_data();
-  tree_hash=0;
-  for (int node=0;node<no_nodes;++node)      
-    tree_hash+=(nodes_hash[node]=node_data[node].hash());
-  if (tree_hash==HASH_NOT_COMPUTED) tree_hash=~HASH_NOT_COMPUTED;
-}	
-
-template<typename Arrow> void TreeBase<Arrow>::compute_hash_and_cache_result_ordered() const {
-    for (auto& arrow: arrows()) assert(arrow.node_in>arrow.node_out);
-  	vector<tree_impl::NodePathDataOrdered> data(no_nodes);
-    for (int node=no_nodes-1;node>=0;--node)
+template<typename Arrow> void TreeBase<Arrow>::compute_hash_and_cache_result(const vector<int>& topological_order) const {
+  	vector<tree_impl::NodePathData> data(no_nodes);
+    for (int node : topological_order)
       for (auto& arrow: arrows()) 
          if (arrow.node_out==node) data[node].add_incoming_arrows(data[arrow.node_in]);
-    for (int node=0;node<no_nodes;++node)
+    for (auto node=topological_order.rbegin();node!=topological_order.rend();++node)
       for (auto& arrow: arrows()) 
-         if (arrow.node_in==node) data[node].add_outgoing_arrows(data[arrow.node_out]);
+         if (arrow.node_in==*node) data[*node].add_outgoing_arrows(data[arrow.node_out]);
     tree_hash=0;
-    for (int node=0;node<no_nodes;++node)      
+    tree_invariant=0;
+    for (int node=0;node<no_nodes;++node) {
       tree_hash+=(nodes_hash[node]=data[node].hash());
+      tree_invariant+=(nodes_invariant[node]=data[node].invariant());
+    }
     if (tree_hash==HASH_NOT_COMPUTED) tree_hash=~HASH_NOT_COMPUTED;    
 }
 
+template<typename Arrow> void TreeBase<Arrow>::compute_hash_and_cache_result_unordered() const {
+	compute_hash_and_cache_result(tree_impl::topological_order(no_nodes,arrows()));
+}	
+
+template<typename Arrow> void TreeBase<Arrow>::compute_hash_and_cache_result_ordered() const {
+    for (auto& arrow: arrows()) assert(arrow.node_in>arrow.node_out);
+    vector<int> topological_order(no_nodes);
+    iota(topological_order.rbegin(),topological_order.rend(),0);
+    compute_hash_and_cache_result(topological_order);
+}
+
 
 
+//equal certificates imply equal hashes, so the certificate alone is used as a key; the cost is linear in the number of trees
 template<typename Tree> void remove_equivalent_trees_same_hash(list<Tree>& list_of_trees) {
- for (auto i=list_of_trees.begin();i!=list_of_trees.end();++i) {
-  auto j=i;
-  ++j;
-  while (j!=list_of_trees.end())
-    if (i->is_equivalent_to(*j)) 
-        j=list_of_trees.erase(j);
-      else ++j;
- }
+  unordered_set<string> certificates;
+  certificates.reserve(list_of_trees.size());
+  list_of_trees.remove_if([&certificates] (const Tree& tree) {
+    return !certificates.insert(tree.canonical_certificate().second).second;
+  });
 }
 
 
+//tells how many trees have the same hash, and how many of those are not already distinguished by their 64-bit invariant
+template<typename Tree> void log_bucket_sizes(const map<int, list<Tree>>& tree_by_hash) {
+  int trees=0, largest_bucket=0, hash_collisions=0;
+  for (auto& hash_and_list : tree_by_hash) {
+    int size=hash_and_list.second.size();
+    trees+=size;
+    largest_bucket=std::max(largest_bucket,size);
+    set<uint64_t> invariants;
+    for (auto& tree: hash_and_list.second) invariants.insert(tree.invariant());
+    hash_collisions+=invariants.size()-1;
+  }
+  nice_log<<trees<<" trees in "<<tree_by_hash.size()<<" buckets, largest bucket has "<<largest_bucket<<" trees; "<<hash_collisions<<" hash collisions resolved by invariants"<<endl;
+}
+
 template<typename Tree> void remove_equivalent_trees(list<Tree>& list_of_trees) {
   map<int, list<Tree>> tree_by_hash;
   for (auto i=list_of_trees.begin();i!=list_of_trees.end();) {
@@ -202,8 +255,11 @@ template<typename Tree> void remove_equivalent_trees(list<Tree>& list_of_trees)
     i=next;
    }
   assert(list_of_trees.empty());
+#ifndef NDEBUG
+  log_bucket_sizes(tree_by_hash);	//nice_log discards its input in release builds, so the statistics are not computed
+#endif
   for (auto& hash_and_list : tree_by_hash) {
-    remove_equivalent_trees_same_hash(hash_and_list.second);
+    if (hash_and_list.second.size()>1) remove_equivalent_trees_same_hash(hash_and_list.second);
     list_of_trees.splice(list_of_trees.end(), hash_and_list.second);
   }
   for (auto tree : list_of_trees)
@@ -211,3 +267,74 @@ template<typename Tree> void remove_equivalent_trees(list<Tree>& list_of_trees)
 }
   
   
+
+template<typename Tree> bool InequivalentTrees<Tree>::insert(const Tree& tree) {
+  return certificates.insert(tree.canonical_certificate()).second;
+}
+
+namespace tree_impl {
+  //may_add_node(tree,list_of_arrows,nodes) should return false if no valid tree can be obtained by adding to tree a node with arrows list_of_arrows, followed by nodes more nodes;
+  //this prunes the enumeration before the enlarged tree is even constructed. For nodes=0, it should return whether the resulting tree is valid.
+  //layer holds the bitmasks of the destinations of the nodes added so far, in increasing order; when the last node is added, the tree is only
+  //constructed if is_new_layer(layer) returns true.
+  template<typename Closure, typename LayerFilter, typename Visitor>
+  void for_each_way_to_add_nodes(const Tree& tree, int nodes, ListOfArrows first_list_of_arrows, vector<uint64_t>& layer, Closure&& may_add_node, LayerFilter&& is_new_layer, Visitor&& visitor) {
+    assert(nodes>0);
+    while (!first_list_of_arrows.is_this_the_end()) {
+      if (may_add_node(tree,first_list_of_arrows,nodes-1)) {
+        layer.push_back(first_list_of_arrows.bitmask());
+        if (nodes>1 || is_new_layer(static_cast<const vector<uint64_t>&>(layer))) {
+          auto enlarged_tree=tree;
+          enlarged_tree.add_node_with_arrows(first_list_of_arrows);
+          if (nodes==1) visitor(static_cast<const Tree&>(enlarged_tree));
+          else for_each_way_to_add_nodes(enlarged_tree,nodes-1,first_list_of_arrows,layer,may_add_node,is_new_layer,visitor);
+        }
+        layer.pop_back();
+      }
+      ++first_list_of_arrows;
+    }
+  }
+
+  inline bool every_layer(const vector<uint64_t>&) {return true;}
+}
+
+template<typename Visitor> void WaysToAddANode::for_each_way_to_add_last_nodes(const Tree& tree, int nodes, Visitor&& visitor) const {
+  auto may_add_node = [] (const Tree& tree, const ListOfArrows& destinations, int remaining_nodes) {return tree.may_be_completed_by_adding(destinations,remaining_nodes);};
+  vector<uint64_t> layer;
+  tree_impl::for_each_way_to_add_nodes(tree,nodes,first(),layer,may_add_node,tree_impl::every_layer,std::forward<Visitor>(visitor));
+}
+
+template<typename Visitor> void WaysToAddANode::for_each_way_to_add_last_nodes_up_to_automorphisms(const Tree& tree, int nodes, Visitor&& visitor) const {
+  auto may_add_node = [] (const Tree& tree, const ListOfArrows& destinations, int remaining_nodes) {return tree.may_be_completed_by_adding(destinations,remaining_nodes);};
+  LayersUpToAutomorphisms layers{tree};
+  vector<uint64_t> layer;
+  tree_impl::for_each_way_to_add_nodes(tree,nodes,first(),layer,may_add_node,[&layers] (const vector<uint64_t>& layer) {return layers.is_new(layer);},std::forward<Visitor>(visitor));
+}
+
+//The nodes added last are those with no incoming arrows, so equivalent completions can only arise from equivalent trees; 
+//this means that equivalent completions of distinct trees in trees_to_complete(partition) cannot occur.
+//With orderly generation, one layer is generated for each orbit under the automorphism group, so no certificates need to be compared.
+template<typename Visitor>
+void for_each_completion(const Tree& tree, int nodes, Visitor&& visitor, EnumerationOptions options) {
+	if (options.orderly_generation()) {
+		tree.ways_to_add_a_node().for_each_way_to_add_last_nodes_up_to_automorphisms(tree,nodes,std::forward<Visitor>(visitor));
+		return;
+	}
+	InequivalentTrees<Tree> inequivalent_trees;
+	auto visit_if_new = [&inequivalent_trees,&visitor] (const Tree& tree) {
+		if (inequivalent_trees.insert(tree)) visitor(tree);
+	};
+	tree.ways_to_add_a_node().for_each_way_to_add_last_nodes(tree,nodes,visit_if_new);
+}
+
+template<typename Visitor>
+void for_each_tree(const vector<int>& partition, Visitor&& visitor, EnumerationOptions options) {
+	nice_log<<"enumerating trees with partition "<<horizontal(partition)<<endl;
+	auto to_complete=trees_to_complete(partition,options);
+	nice_log<<to_complete.size()<<" trees to complete"<<endl;
+	auto counter= nice_log.counter("completing tree",100);
+	for (auto& tree: to_complete) {
+		nice_log<<counter;
+		for_each_completion(tree,partition[0],visitor,options);
+	}
+}
@@ -89,30 +89,60 @@ unique_ptr<DiagonalMetric> make_diagonal_metric(const string& name, const Weight
 
 DiagramProperties:: DiagramProperties(const WeightMatrix& weight_matrix, const list<vector<int>>& automorphisms, DiagramDataOptions options) : 
  	options{options},
- 	no_rows{weight_matrix.M_Delta().rows()},
- 	no_cols{weight_matrix.M_Delta().cols()},
+ 	weight_matrix{make_unique<WeightMatrix>(weight_matrix)},
+ 	no_rows{weight_matrix.rows()},
+ 	no_cols{weight_matrix.cols()},
   rank_over_Q{weight_matrix.rank_over_Q()},
   rank_over_Z2{weight_matrix.rank_over_Z2()},
-  automorphisms{automorphisms},
-  imMDelta2{options.sign_configurations_limit? "not computed" : image_mod2(weight_matrix).to_string()}, 	
- 	ricci_flat_antidiagonal{options.with_antidiagonal_ricci_flat_sigma()? ricci_flat_sigma(weight_matrix) : list<OrderTwoAutomorphism>{}},
- 	diagram_analyzer{options.analyze_diagram()? DiagramAnalyzer{weight_matrix.cols(),vector<WeightAndCoefficient>{weight_matrix.weight_begin(),weight_matrix.weight_end()}} : DiagramAnalyzer{}},
-  kernel_of_MDelta_transpose{X_solving_Ricciflat(weight_matrix)}
-{
-	auto nilsoliton_X=X_solving_nilsoliton(weight_matrix);
-	b=nilsoliton_X;	
-	B=accumulate(b.begin(),b.end(),ex{0});
-	auto diagonal_ricci_flat_X=X_solving_Ricciflat(weight_matrix);
-	if (options.with_diagonal_nilsoliton_metrics())
-		metrics.push_back(make_diagonal_metric(NILSOLITON_DIAGONAL(), weight_matrix,nilsoliton_X,options));
-	if (options.with_diagonal_ricci_flat_metrics())
-		metrics.push_back(make_diagonal_metric(RICCI_FLAT_DIAGONAL(), weight_matrix,diagonal_ricci_flat_X,options));
-	nikolayevsky=to_matrix(transpose(weight_matrix.M_Delta())).image_of(nilsoliton_X);
-	for (auto& x: nikolayevsky) ++x;
-	if (options.with_sigma_compatible_ricci_flat_metrics()) 
-		for (auto& sigma: automorphisms)
-			if (has_order_two(sigma))
-				metrics.push_back(make_unique<SigmaCompatibleMetric> (RICCI_FLAT_SIGMA(),weight_matrix, symmetrize(diagonal_ricci_flat_X,weight_matrix.sigma_on_VDelta(sigma)), sigma));
+  automorphisms{automorphisms}
+{}
+
+DiagramProperties::~DiagramProperties()=default;
+
+const DiagramProperties::NilsolitonData& DiagramProperties::nilsoliton() const {
+	return nilsoliton_.get([this] () {
+		NilsolitonData result;
+		result.b=X_solving_nilsoliton(*weight_matrix);
+		result.B=accumulate(result.b.begin(),result.b.end(),ex{0});
+		result.nikolayevsky=to_matrix(transpose(weight_matrix->M_Delta())).image_of(result.b);
+		for (auto& x: result.nikolayevsky) ++x;
+		return result;
+	});
+}
+
+const exvector& DiagramProperties::kernel_of_MDelta_transpose() const {
+	return kernel_of_MDelta_transpose_.get([this] () {return X_solving_Ricciflat(*weight_matrix);});
+}
+
+const list<unique_ptr<ImplicitMetric>>& DiagramProperties::metrics() const {
+	return metrics_.get([this] () {
+		list<unique_ptr<ImplicitMetric>> metrics;
+		if (options.with_diagonal_nilsoliton_metrics())
+			metrics.push_back(make_diagonal_metric(NILSOLITON_DIAGONAL(), *weight_matrix,nilsoliton().b,options));
+		if (options.with_diagonal_ricci_flat_metrics())
+			metrics.push_back(make_diagonal_metric(RICCI_FLAT_DIAGONAL(), *weight_matrix,kernel_of_MDelta_transpose(),options));
+		if (options.with_sigma_compatible_ricci_flat_metrics()) 
+			for (auto& sigma: automorphisms)
+				if (has_order_two(sigma))
+					metrics.push_back(make_unique<SigmaCompatibleMetric> (RICCI_FLAT_SIGMA(),*weight_matrix, symmetrize(kernel_of_MDelta_transpose(),weight_matrix->sigma_on_VDelta(sigma)), sigma));
+		return metrics;
+	});
+}
+
+string DiagramProperties::imMDelta2() const {
+	if (options.sign_configurations_limit) return "not computed";
+	return imMDelta2_.get([this] () {return image_mod2(*weight_matrix).to_string();});
+}
+
+list<OrderTwoAutomorphism> DiagramProperties::automorphisms_giving_ricci_flat() const {
+	if (!options.with_antidiagonal_ricci_flat_sigma()) return {};
+	return ricci_flat_antidiagonal_.get([this] () {return ricci_flat_sigma(*weight_matrix);});
+}
+
+const DiagramAnalyzer& DiagramProperties::diagram_analyzer() const {
+	return diagram_analyzer_.get([this] () {
+		return options.analyze_diagram()? DiagramAnalyzer{weight_matrix->cols(),vector<WeightAndCoefficient>{weight_matrix->weight_begin(),weight_matrix->weight_end()}} : DiagramAnalyzer{};
+	});
 }
 
   
@@ -130,22 +160,22 @@ void DiagramProperties::print_matrix_data(ostream& os) const {
 	    os<<"derivations are traceless"<<endl;
     }
     else {
-	    os<<"Nikolayevsky derivation: "<<nikolayevsky<<endl;
+	    os<<"Nikolayevsky derivation: "<<nilsoliton().nikolayevsky<<endl;
 	  }
     os<<"rank over Z_2 = "<<rank_over_Z2<<endl;
 	  os<<"rank over Q = "<<rank_over_Q<<endl;
 	  os<<"dim ker M_Delta = "<< dimension_kernel_M_Delta()<<endl;
 	  os<<"dim coker M_Delta = "<<dimension_cokernel_M_Delta()<<endl;
 	  if (dimension_cokernel_M_Delta()) {
-		  os<<" kernel of (M_Delta)^T "<<kernel_of_MDelta_transpose<<"; generators:"<<endl;
-		 	for (auto v : basis_from_generic_element<Unknown>(kernel_of_MDelta_transpose)) os<<v<<endl;
+		  os<<" kernel of (M_Delta)^T "<<kernel_of_MDelta_transpose()<<"; generators:"<<endl;
+		 	for (auto v : basis_from_generic_element<Unknown>(kernel_of_MDelta_transpose())) os<<v<<endl;
 		  list<ex> symbols;
-		  for (auto entry : kernel_of_MDelta_transpose)
+		  for (auto entry : kernel_of_MDelta_transpose())
 		  for (auto symbol : symbols) 
 		  	if (abs(entry.coeff(symbol))>1) os<<"unexpected coefficient"<<endl;  
 		 }
-    os<<"B="<<B<<endl;
-    os<<"b="<<horizontal(b)<<endl;
+    os<<"B="<<nilsoliton().B<<endl;
+    os<<"b="<<horizontal(nilsoliton().b)<<endl;
 }
 
 
@@ -153,11 +183,11 @@ string DiagramProperties::diagram_data() const {
  		stringstream sstream;
  		if (options.with_matrix_data()) print_matrix_data(sstream);
  		if (options.with_im_delta2())
-	    sstream<<"Im M_Delta2: "<<endl<<imMDelta2<<endl;
-	  for (auto& metric : metrics) 
+	    sstream<<"Im M_Delta2: "<<endl<<imMDelta2()<<endl;
+	  for (auto& metric : metrics()) 
 	   	sstream<<metric->to_string()<<endl;
 	  if (options.analyze_diagram())
-	  	sstream<<diagram_analyzer.analysis()<<endl;
+	  	sstream<<diagram_analyzer().analysis()<<endl;
     /*
     for (auto x: SignConfiguration::all_configurations(nilsoliton_Y_ijk.size())) {
 			exvector with_signs;
@@ -166,6 +196,7 @@ string DiagramProperties::diagram_data() const {
 			if ( LinearInequalities{with_signs.begin(),with_signs.end(),Unknown{}}.has_solution()) sstream<<"orthant : "<<x<<endl;
 		}*/
 		if (options.with_antidiagonal_ricci_flat_sigma()) {
+			auto ricci_flat_antidiagonal=automorphisms_giving_ricci_flat();
 	    if (ricci_flat_antidiagonal.empty()) sstream<<"no ricci-flat antidiagonal sigma"<<endl;
 			else sstream<<"ricci-flat antidiagonal sigma: "<<cut_at(ricci_flat_antidiagonal,options.ricci_flat_antidiagonal_limit)<<endl;
 		}
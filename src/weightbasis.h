@@ -26,6 +26,7 @@
 #include "implicitmetric.h"
 #include "antidiagonal.h"
 #include "diagramanalyzer.h"
+#include <mutex>
 
 using namespace GiNaC;
 using namespace Wedge;
@@ -55,13 +56,29 @@ ostream& operator<<(ostream& os,WeightAndCoefficient weight);
 
 class WeightMatrix;
 
+//a value computed on first access; safe to read from concurrent threads
+template<typename T>
+class LazyValue {
+	mutable std::once_flag computed;
+	mutable T value;
+public:
+	template<typename Compute>
+	const T& get(Compute&& compute) const {
+		std::call_once(computed,[this,&compute] () {value=compute();});
+		return value;
+	}
+};
+
+//each property is computed the first time it is read, so that runs which only need some of them (e.g. filters) do not pay for the others
 class DiagramProperties {
 public:
   DiagramProperties(const WeightMatrix& weight_matrix, const list<vector<int>>& automorphisms, DiagramDataOptions options);
+  ~DiagramProperties();
  	int dimension_kernel_M_Delta() const {return no_cols-rank_over_Q;}
  	int dimension_cokernel_M_Delta() const {return no_rows-rank_over_Q;}
  	string diagram_data() const;
  	bool potentially_admits_metrics() const {
+ 		auto& metrics=this->metrics();
  		assert(!metrics.empty());
  		auto result=any_of(metrics.begin(),metrics.end(),
  			[](auto& metric) {return !metric->no_metric_regardless_of_polynomial_conditions();});
@@ -69,7 +86,7 @@ public:
  	}
  	string polynomial_conditions(const exvector& csquared) const {
  		string result;
- 		for (auto& metric : metrics) {
+ 		for (auto& metric : metrics()) {
  			if (metric->no_metric_regardless_of_polynomial_conditions()) continue;
  			result+=metric->name();
  			auto polynomial_equations=metric->polynomial_equations_for_existence(csquared);
@@ -80,46 +97,62 @@ public:
  		return result; 		
  	}
   bool are_all_derivations_traceless() const {
+  	auto& nikolayevsky=nilsoliton().nikolayevsky;
 		return all_of(nikolayevsky.begin(),nikolayevsky.end(),[] (ex x) {return x.is_zero();});
 	}
 	bool has_nontrivial_automorphisms() const {return !automorphisms.empty();}
 	
 	string classification_of_metrics(const exvector& csquared) const {
 		string result;
-		for (auto& metric : metrics)
+		for (auto& metric : metrics())
 			result+=metric->name()+"&"+metric->classification(csquared);
 		return result;
 	}
 	
 	const ImplicitMetric* diagonal_nilsoliton_metric() const {
-		auto it=find_if(metrics.begin(),metrics.end(),[] (auto& metric) {return metric->name()==NILSOLITON_DIAGONAL();});
-		return it!=metrics.end()? it->get() : nullptr;
+		return metric_named(NILSOLITON_DIAGONAL());
 	}
 	const ImplicitMetric* diagonal_ricci_flat_metric() const {
-		auto it=find_if(metrics.begin(),metrics.end(),[] (auto& metric) {return metric->name()==RICCI_FLAT_DIAGONAL();});
-		return it!=metrics.end()? it->get() : nullptr;
+		return metric_named(RICCI_FLAT_DIAGONAL());
 	}
 	bool matches(DiagramDataOptions options) const {return this->options==options;}
-	list<OrderTwoAutomorphism> automorphisms_giving_ricci_flat() const {return ricci_flat_antidiagonal;}
-	exvector nikolayevsky_derivation() const {return nikolayevsky;}
-	bool simple_nikolayevsky_derivation() const {return set<ex,ex_is_less>(nikolayevsky.begin(),nikolayevsky.end()).size()==nikolayevsky.size();}
+	list<OrderTwoAutomorphism> automorphisms_giving_ricci_flat() const;
+	exvector nikolayevsky_derivation() const {return nilsoliton().nikolayevsky;}
+	bool simple_nikolayevsky_derivation() const {
+		auto& nikolayevsky=nilsoliton().nikolayevsky;
+		return set<ex,ex_is_less>(nikolayevsky.begin(),nikolayevsky.end()).size()==nikolayevsky.size();
+	}
 private:
 	static string RICCI_FLAT_DIAGONAL() {return "Ricci-flat(diag)"s;}
 	static string RICCI_FLAT_SIGMA() {return "Ricci-flat(sigma)"s;}
 	static string NILSOLITON_DIAGONAL() {return "nilsoliton(diag)"s;}
+	struct NilsolitonData {
+		exvector b;		//X solving the nilsoliton equation
+		ex B;				//sum of the entries of b
+		exvector nikolayevsky;
+	};
 	DiagramDataOptions options;
 	void print_matrix_data(ostream& os) const;
+	const NilsolitonData& nilsoliton() const;
+	const exvector& kernel_of_MDelta_transpose() const;
+	const list<unique_ptr<ImplicitMetric>>& metrics() const;
+	const ImplicitMetric* metric_named(const string& name) const {
+		auto& metrics=this->metrics();
+		auto it=find_if(metrics.begin(),metrics.end(),[&name] (auto& metric) {return metric->name()==name;});
+		return it!=metrics.end()? it->get() : nullptr;
+	}
+	string imMDelta2() const;
+	const DiagramAnalyzer& diagram_analyzer() const;	//combinatorial data about the diagram
+	unique_ptr<const WeightMatrix> weight_matrix;
   int no_rows, no_cols, rank_over_Q;
   int rank_over_Z2;
-  list<unique_ptr<ImplicitMetric>> metrics;
-	exvector nikolayevsky;
 	list<vector<int>> automorphisms;
-	string imMDelta2;
-	list<OrderTwoAutomorphism> ricci_flat_antidiagonal;
-	DiagramAnalyzer diagram_analyzer;		//combinatorial data about the diagram
-	ex B;
-	exvector b;
-  exvector kernel_of_MDelta_transpose;
+  LazyValue<NilsolitonData> nilsoliton_;
+  LazyValue<exvector> kernel_of_MDelta_transpose_;
+  LazyValue<list<unique_ptr<ImplicitMetric>>> metrics_;
+  LazyValue<string> imMDelta2_;
+	LazyValue<list<OrderTwoAutomorphism>> ricci_flat_antidiagonal_;
+	LazyValue<DiagramAnalyzer> diagram_analyzer_;
 };
 
 
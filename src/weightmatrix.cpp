@@ -46,17 +46,10 @@ public:
 	}
 };
 
-Matrix matrix_from_weights(const vector<WeightAndCoefficient>& weights,int dimension) {
-	Matrix result{weights.size(),dimension};
-	for (int i=0;i<weights.size();++i) 
-		populate_row(i,weights[i],result);
-	return result;
-}
-
-
-
 WeightMatrix::WeightMatrix(vector<WeightAndCoefficient>&& unordered_weights,int dimension) : weights{move(unordered_weights)}, cols_{dimension} { 
-	basis_over_Z2 = ::independent_rows_over_Z2(matrix_from_weights(weights,dimension));
+	GF2Matrix matrix_mod2{dimension};
+	for (auto& weight: weights) matrix_mod2.add_row(row_mod2(weight));
+	basis_over_Z2 = matrix_mod2.independent_rows();
 	independent_rows_over_Z2=basis_over_Z2.size();
 	for (auto row : basis_over_Z2) 
 			weights[row].eliminate_sign_and_parameter();
@@ -92,11 +85,24 @@ SignConfiguration vector_to_sign_configuration(const vector<Z2>& epsilon) {
 }
 
 
+SignConfiguration bitmask_to_sign_configuration(int dimension, uint64_t epsilon) {
+	SignConfiguration result{dimension};
+	for (;epsilon;epsilon&=epsilon-1) result[__builtin_ctzll(epsilon)]=-1;
+	return result;
+}
+
 ImageMod2 image_mod2(const WeightMatrix& weight_matrix) {
+	map<PackedZ2Vector,vector<uint64_t>> preimages;
+	weight_matrix.for_each_image_mod2([&preimages] (uint64_t delta, const PackedZ2Vector& image) {
+		preimages[image].push_back(delta);
+	});
+	//preimages are listed in the order of SignConfiguration::all_configurations, i.e. by increasing bitmask
 	ImageMod2 result;
-	for (auto delta : SignConfiguration::all_configurations(weight_matrix.cols())) {
-		auto vector=sign_configuration_to_vector(weight_matrix.cols(),delta);
-		result.insert(sign_configuration_to_string(delta), weight_matrix.image_of(vector));
+	for (auto& image_and_preimages : preimages) {
+		auto image=unpack(image_and_preimages.first,weight_matrix.rows());
+		sort(image_and_preimages.second.begin(),image_and_preimages.second.end());
+		for (auto delta : image_and_preimages.second)
+			result.insert(sign_configuration_to_string(bitmask_to_sign_configuration(weight_matrix.cols(),delta)),image);
 	}
 	return result;
 }
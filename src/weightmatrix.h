@@ -20,6 +20,7 @@
 
 #include "matrixbuilder.h"
 #include "weightbasis.h"
+#include "gf2matrix.h"
 
 template<typename Matrix>
 void populate_row(int row, Weight weight, Matrix& matrix) {
@@ -27,6 +28,11 @@ void populate_row(int row, Weight weight, Matrix& matrix) {
  		--matrix(row,weight.node_in1);
    	--matrix(row,weight.node_in2);
 }
+
+//the row of M_Delta corresponding to weight, reduced mod 2
+inline uint64_t row_mod2(Weight weight) {
+	return uint64_t{1}<<weight.node_out ^ uint64_t{1}<<weight.node_in1 ^ uint64_t{1}<<weight.node_in2;
+}
 	
 WEDGE_DECLARE_NAMED_ALGEBRAIC(Unknown,realsymbol);
 
@@ -48,8 +54,17 @@ inline ostream& operator<<(ostream& os, Z2 x) {
 	return os<< (x==Z2{}? 0 : 1);
 }
 
+//vectors in Z_2^n can also be stored with one bit per entry
+using PackedZ2Vector = vector<uint64_t>;
+inline vector<Z2> unpack(const PackedZ2Vector& packed, int size) {
+	vector<Z2> result(size);
+	for (int i=0;i<size;++i) result[i]=packed[i/64]>>i%64 & 1;
+	return result;
+}
+
 vector<Z2> sign_configuration_to_vector(int dimension, const SignConfiguration& epsilon);
 SignConfiguration vector_to_sign_configuration(const vector<Z2>& epsilon);
+SignConfiguration bitmask_to_sign_configuration(int dimension, uint64_t epsilon);
 
 class WeightIterator {
 	const vector<WeightAndCoefficient>& weights;
@@ -85,22 +100,12 @@ class WeightMatrix {
   	assert (it!=weights.end());
   	return it-weights.begin();
 	}
-  Matrix submatrix_JDelta2() const {
-  	Matrix submatrix{independent_rows_over_Z2,cols_};
-	 	auto weight=Z2basis_begin();
- 	  for (int i=0;i<submatrix.rows();++i)
- 			populate_row(i, *weight++,submatrix);
- 		assert (weight==Z2basis_end());
- 		return submatrix;
+  GF2Matrix submatrix_JDelta2() const {
+  	GF2Matrix submatrix{cols_};
+  	for (auto weight=Z2basis_begin();weight!=Z2basis_end();++weight)
+  		submatrix.add_row(row_mod2(*weight));
+  	return submatrix;
   }
-  Matrix submatrix_IDelta_setminus_JDelta2() const {
-    Matrix submatrix{weights.size()-independent_rows_over_Z2,cols_};
-	 	auto weight=complement_of_Z2basis_begin();
- 	  for (int i=0;i<submatrix.rows();++i)
- 			populate_row(i, *weight++,submatrix);
- 		assert (weight==complement_of_Z2basis_end());
- 		return submatrix;
-	}
 public:
 	WeightMatrix(vector<WeightAndCoefficient>&& weights,int dimension);
 	template<typename Container> 
@@ -128,6 +133,26 @@ public:
   	for (auto x: weights) result.push_back(v[x.node_in1] + v[x.node_in2]+v[x.node_out]);
   	return result;
   }
+  //calls visitor(epsilon,image) for each epsilon in Z_2^cols, given as a bitmask of nodes, with image the packed image of epsilon under M_Delta mod 2;
+  //epsilon runs through a Gray code, so that each image is obtained from the previous one by adding a column
+  template<typename Visitor>
+  void for_each_image_mod2(Visitor&& visitor) const {
+  	assert(cols_<64);
+  	int words=(rows()+63)/64;
+  	vector<PackedZ2Vector> columns(cols_,PackedZ2Vector(words));
+  	for (int i=0;i<rows();++i)
+  		for (auto row=row_mod2(weights[i]);row;row&=row-1)
+  			columns[__builtin_ctzll(row)][i/64]|=uint64_t{1}<<i%64;
+  	PackedZ2Vector image(words);
+  	uint64_t epsilon=0;
+  	visitor(epsilon,static_cast<const PackedZ2Vector&>(image));
+  	for (uint64_t step=1;step<uint64_t{1}<<cols_;++step) {
+  		int node=__builtin_ctzll(step);
+  		epsilon^=uint64_t{1}<<node;
+  		for (int i=0;i<words;++i) image[i]^=columns[node][i];
+  		visitor(epsilon,static_cast<const PackedZ2Vector&>(image));
+  	}
+  }
   vector<int> sigma_on_VDelta(const vector<int>& sigma) const {
 		vector<int> result;
 		transform(weights.begin(),weights.end(),back_inserter(result),
@@ -135,6 +160,20 @@ public:
 		);
 		return result;
   }
+  //for each weight in IDelta\JDelta2, the coefficients expressing its row mod 2 as a combination of the rows in JDelta2, which are a basis over Z_2
+  vector<uint64_t> complement_of_Z2basis_in_Z2basis() const {
+  	auto JDelta2_transpose=submatrix_JDelta2().transpose();
+  	vector<uint64_t> result;
+  	for (auto weight=complement_of_Z2basis_begin();weight!=complement_of_Z2basis_end();++weight) {
+  		auto row=row_mod2(*weight);
+  		vector<bool> constant_terms(cols_);
+  		for (int j=0;j<cols_;++j) constant_terms[j]=row>>j & 1;
+  		auto coefficients=JDelta2_transpose.solve(constant_terms);
+  		assert(coefficients);
+  		result.push_back(*coefficients);
+  	}
+  	return result;
+  }
   WeightIterator Z2basis_begin() const {return WeightIterator{weights,basis_over_Z2.begin()};}
   WeightIterator Z2basis_end() const {return WeightIterator{weights,basis_over_Z2.end()};}
   WeightIterator complement_of_Z2basis_begin() const {return WeightIterator{weights,complement_of_basis_over_Z2.begin()};}
@@ -156,18 +195,70 @@ exvector X_solving_nilsoliton(const WeightMatrix& MDelta);
 
 class SignConfigurations {
  	const WeightMatrix& MDelta;
- 	list<SignConfiguration> sign_configurations_;
+ 	int sign_ambiguities;
+ 	//configurations are numbered in the order of SignConfiguration::all_configurations, so that bit i of the index is set when the i-th sign is -1;
+ 	//the configurations considered are those with index below number_of_configurations, and survivors are those not eliminated
+ 	uint64_t number_of_configurations;
+ 	vector<bool> eliminated;
  	
+  vector<uint64_t> delta_projector;	//for each row in IDelta\JDelta2, the rows of JDelta2 that add up to it mod 2
+
+	//a set of signs, one bit per sign ambiguity, with the same numbering as indices
+	using SignMask = vector<uint64_t>;
+	SignMask to_mask(const SignConfiguration& epsilon) const {
+		SignMask result((sign_ambiguities+63)/64);
+		for (int i=0;i<sign_ambiguities;++i)
+			if (epsilon[i]<0) result[i/64]|=uint64_t{1}<<i%64;
+		return result;
+	}
+	SignConfiguration to_sign_configuration(uint64_t index) const {
+		SignConfiguration result{sign_ambiguities};
+		for (;index;index&=index-1) result[__builtin_ctzll(index)]=-1;
+		return result;
+	}
+	
+	//delta(sigma,-) is an affine map over Z_2; it is stored as its value at the trivial configuration and its linear part on the signs that can appear in an index
+	struct AffineMap {
+		SignMask constant;
+		vector<SignMask> columns;
+		SignMask operator()(uint64_t index) const {
+			auto result=constant;
+			for (;index;index&=index-1) {
+				auto& column=columns[__builtin_ctzll(index)];
+				for (int i=0;i<result.size();++i) result[i]^=column[i];
+			}
+			return result;
+		}
+	};
+	AffineMap delta_as_affine_map(const vector<int>& sigma) const {
+		AffineMap result;
+		result.constant=to_mask(delta(sigma,to_sign_configuration(0)));
+		for (int j=0;j<64 && uint64_t{1}<<j<number_of_configurations;++j) {
+			auto column=to_mask(delta(sigma,to_sign_configuration(uint64_t{1}<<j)));
+			for (int i=0;i<column.size();++i) column[i]^=result.constant[i];
+			result.columns.push_back(move(column));
+		}
+		return result;
+	}
+	optional<uint64_t> index_of(const SignMask& mask) const {
+		if (any_of(mask.begin()+1,mask.end(),[] (uint64_t word) {return word!=0;}) || mask[0]>=number_of_configurations) return nullopt;
+		return mask[0];
+	}
+
+	//keeps the first configuration in each orbit; each surviving configuration eliminates its images, as they are reached in order
   void factor_out_automorphisms(const list<vector<int>>& nontrivial_automorphisms) {
-  	if (sign_configurations_.empty()) return;
-  	for (auto epsilon = sign_configurations_.begin();epsilon!=sign_configurations_.end();++epsilon) {
-  		for (auto& sigma : nontrivial_automorphisms) {
-  			auto delta_sigma_epsilon=delta(sigma, *epsilon);
-  			if (delta_sigma_epsilon!=*epsilon) {
-  				nice_log<<"used "<<sigma<<"("<<*epsilon<<") to eliminate "<<delta_sigma_epsilon<<endl;
-	  			sign_configurations_.remove(delta_sigma_epsilon);
-	  		}
-	  	}
+  	if (!sign_ambiguities || nontrivial_automorphisms.empty()) return;	//with no signs, the only configuration is fixed by all automorphisms
+  	vector<AffineMap> delta_sigma;
+  	for (auto& sigma : nontrivial_automorphisms) delta_sigma.push_back(delta_as_affine_map(sigma));
+  	for (uint64_t epsilon=0;epsilon<number_of_configurations;++epsilon) {
+  		if (eliminated[epsilon]) continue;
+  		for (auto& delta : delta_sigma) {
+  			auto delta_sigma_epsilon=index_of(delta(epsilon));
+  			if (delta_sigma_epsilon && *delta_sigma_epsilon!=epsilon) {
+  				nice_log<<"used configuration "<<epsilon<<" to eliminate "<<*delta_sigma_epsilon<<endl;
+  				eliminated[*delta_sigma_epsilon]=true;
+  			}
+  		}
   	}
   }
   
@@ -185,7 +276,7 @@ class SignConfigurations {
   	return {logsign,index};
   }
   	
-	vector<Z2> sigma_w_projection_to_JDelta2(const vector<int>& sigma, const vector<Z2>& w) {
+	vector<Z2> sigma_w_projection_to_JDelta2(const vector<int>& sigma, const vector<Z2>& w) const {
 		vector<Z2> result(MDelta.rank_over_Z2());
 		transform(MDelta.Z2basis_begin(),MDelta.Z2basis_end(),result.begin(),
 			[this,&sigma,&w] (Weight weight) {
@@ -196,7 +287,7 @@ class SignConfigurations {
 		nice_log<<"sigma_w_projection_to_JDelta2= "<<horizontal(result)<<endl;
 		return result;
   }
-  vector<Z2> sigma_w_projection_to_IDelta_minus_JDelta2(const vector<int>& sigma, const vector<Z2>& w) {
+  vector<Z2> sigma_w_projection_to_IDelta_minus_JDelta2(const vector<int>& sigma, const vector<Z2>& w) const {
   	vector<Z2>  result(MDelta.rows()-MDelta.rank_over_Z2());
 		transform(MDelta.complement_of_Z2basis_begin(),MDelta.complement_of_Z2basis_end(),result.begin(),
 			[this,&sigma,&w] (Weight weight) {
@@ -207,37 +298,49 @@ class SignConfigurations {
 		return result;
   }
   
-  SignConfiguration delta(const vector<int>& sigma, const SignConfiguration& epsilon) {
-  		auto w_epsilon=MDelta.w_epsilon(epsilon);
-  		auto sigma_w_projection_to_JDelta2=this->sigma_w_projection_to_JDelta2(sigma,w_epsilon);
-  		auto variables=	 generate_variables<Unknown>(N.a,MDelta.cols());
-	 		auto x=solve_over_Z2(
-	 			complete_matrix(MDelta.submatrix_JDelta2(),exvector{sigma_w_projection_to_JDelta2.begin(),sigma_w_projection_to_JDelta2.end()}),
-				variables
-	 		);
-	 		auto delta=MDelta.submatrix_IDelta_setminus_JDelta2().image_of(x);	
-	 		auto sigma_w=sigma_w_projection_to_IDelta_minus_JDelta2(sigma,w_epsilon);
-			SignConfiguration result{delta.size()};
-			for (int i=0;i<delta.size();++i) {
-				for (auto variable : variables) delta[i]=delta[i].subs(variable==0);
-				nice_log<<delta[i]<<endl;
-				assert(is_a<numeric>(delta[i]));
-				Z2 delta_i{ex_to<numeric>(delta[i]).is_even()? 0 : 1};
-				result[i]=(sigma_w[i]+delta_i).to_Z_star();
-			}
-			return result;
-  	} 
 public:
 	SignConfigurations(const WeightMatrix& MDelta,const list<vector<int>>& nontrivial_automorphisms) :
-		 MDelta{MDelta}, sign_configurations_{SignConfiguration::all_configurations(MDelta.rows()-MDelta.rank_over_Z2())} {
+		 MDelta{MDelta}, sign_ambiguities{MDelta.rows()-MDelta.rank_over_Z2()}, delta_projector{MDelta.complement_of_Z2basis_in_Z2basis()} {
+		if (sign_ambiguities>=64) throw std::runtime_error("SignConfigurations: "+std::to_string(sign_ambiguities)+" sign ambiguities are too many to list all configurations; specify a limit");
+		number_of_configurations=uint64_t{1}<<sign_ambiguities;
+		eliminated.resize(number_of_configurations);
 		factor_out_automorphisms(nontrivial_automorphisms);
 	}
 	SignConfigurations(const WeightMatrix& MDelta,const list<vector<int>>& nontrivial_automorphisms, int limit) :
-		 MDelta{MDelta}, sign_configurations_{SignConfiguration::all_configurations(MDelta.rows()-MDelta.rank_over_Z2(),limit)} {
+		 MDelta{MDelta}, sign_ambiguities{MDelta.rows()-MDelta.rank_over_Z2()}, delta_projector{MDelta.complement_of_Z2basis_in_Z2basis()} {
+		number_of_configurations=std::max(limit,1);
+		if (sign_ambiguities<64 && uint64_t{1}<<sign_ambiguities<=number_of_configurations)
+			number_of_configurations=uint64_t{1}<<sign_ambiguities;
+		else
+			nice_log<<"SignConfiguration::all_configurations invoked with signs="<<sign_ambiguities<<"; ignoring all sign configurations after the first "<<limit<<endl;
+		eliminated.resize(number_of_configurations);
 		factor_out_automorphisms(nontrivial_automorphisms);
 	}
 	
-	list<SignConfiguration> sign_configurations() && {return move(sign_configurations_);}
+	//the configuration obtained from epsilon by the automorphism sigma, as a configuration of the signs in IDelta\JDelta2
+  SignConfiguration delta(const vector<int>& sigma, const SignConfiguration& epsilon) const {
+  		auto w_epsilon=MDelta.w_epsilon(epsilon);
+  		auto sigma_w_projection_to_JDelta2=this->sigma_w_projection_to_JDelta2(sigma,w_epsilon);
+	 		//if x solves the equations in JDelta2, its image on the other rows is determined by expressing them as combinations of the rows in JDelta2
+	 		uint64_t constant_terms=0;
+	 		for (int i=0;i<sigma_w_projection_to_JDelta2.size();++i)
+	 			if (!(sigma_w_projection_to_JDelta2[i]==Z2{})) constant_terms|=uint64_t{1}<<i;
+	 		auto sigma_w=sigma_w_projection_to_IDelta_minus_JDelta2(sigma,w_epsilon);
+			SignConfiguration result{delta_projector.size()};
+			for (int i=0;i<delta_projector.size();++i) {
+				Z2 delta_i{__builtin_parityll(delta_projector[i] & constant_terms)};
+				nice_log<<delta_i<<endl;
+				result[i]=(sigma_w[i]+delta_i).to_Z_star();
+			}
+			return result;
+  	}
+	
+	list<SignConfiguration> sign_configurations() && {
+		list<SignConfiguration> result;
+		for (uint64_t epsilon=0;epsilon<number_of_configurations;++epsilon)
+			if (!eliminated[epsilon]) result.push_back(to_sign_configuration(epsilon));
+		return result;
+	}
 };
 
 /*
@@ -1,4 +1,5 @@
 #include "gauss.cpp"
+#include "gf2matrix.h"
 #include <cassert>
 #include <iostream>
 #include <ginac/ginac.h>
@@ -11,6 +12,12 @@ void test_gauss() {
   assert ( (independent_rows_over_Z2(Matrix{{1,2,3},{2,3,1},{3,1,2}}) == vector<int>{0,1} ));
   assert ( (independent_rows_over_Q(Matrix{{1,2,3},{1,2,3},{2,3,1},{3,1,2}}) == vector<int>{0,2,3} ));
   assert ( (independent_rows_over_Z2(Matrix{{1,2,3},{1,4,3},{2,3,1},{3,1,2}}) == vector<int>{0,2} ));
+  //entries too large for 64-bit elimination, rational entries and symbolic entries
+  ex large=numeric{"100000000000000000000"};
+  assert ( (independent_rows_over_Q(Matrix{{large,1,0},{1,large,0},{large+1,large+1,0}}) == vector<int>{0,1} ));
+  assert ( (independent_rows_over_Q(Matrix{{numeric{1,2},1},{1,2}}) == vector<int>{0} ));
+  symbol x{"x"};
+  assert ( (independent_rows_over_Q(Matrix{{x,1},{x*x,x},{1,x}}) == vector<int>{0,2} ));
 }
 
 void test_matrix() {
@@ -102,6 +109,51 @@ void test_solve_over_Z2() {
 
 }
 
+GF2Matrix to_gf2_matrix(const Matrix& matrix, int cols) {
+  GF2Matrix result{cols};
+  for (int i=0;i<matrix.rows();++i) {
+    uint64_t row=0;
+    for (int j=0;j<cols;++j)
+      if (ex_to<numeric>(matrix(i,j)).to_int()%2) row|=uint64_t{1}<<j;
+    result.add_row(row);
+  }
+  return result;
+}
+
+vector<bool> last_column_mod2(const Matrix& complete_matrix) {
+  vector<bool> result;
+  for (auto x: complete_matrix.column(complete_matrix.cols()-1)) result.push_back(ex_to<numeric>(x).to_int()%2);
+  return result;
+}
+
+void test_gf2_matrix(const Matrix& complete_matrix) {
+  auto matrix=to_gf2_matrix(complete_matrix,complete_matrix.cols()-1);
+  auto constant_terms=last_column_mod2(complete_matrix);
+  auto x=matrix.solve(constant_terms);
+  assert(x.has_value()== !solve_over_Z2(complete_matrix,variables(matrix.cols())).empty());
+  if (x) assert(matrix.image_of(*x)==constant_terms);
+  auto kernel=matrix.kernel();
+  assert(kernel.size()==matrix.cols()-matrix.rank());
+  for (auto v: kernel) assert(matrix.image_of(v)==vector<bool>(matrix.rows()));
+}
+
+void test_gf2_matrix() {
+  for (Matrix m: {Matrix{{1,2,3},{2,3,1},{3,1,2}}, Matrix{{1,2,3},{1,4,3},{2,3,1},{3,1,2}}, Matrix{{1,2,3},{1,2,3},{2,3,1},{3,1,2}}})
+    assert(to_gf2_matrix(m,m.cols()).independent_rows()==independent_rows_over_Z2(m));
+  test_gf2_matrix({{1,2,3,0},{4,5,6,0},{7,8,9,1}});
+  test_gf2_matrix({{1,2,3,1},{4,5,6,0},{7,8,9,1}});
+  test_gf2_matrix(
+    {{1,0,-1,0,0,0,0,-1,0,1},
+    {1,0,0,-1,0,0,0,0,-1,0},
+    {1,0,0,0,-1,0,-1,0,0,1},
+    {0,1,0,0,-1,0,0,0,-1,1},
+    {0,0,1,0,0,-1,0,-1,0,1},
+    {0,0,0,1,0,-1,0,0,-1,0},
+    {0,1,0,0,0,0,-1,-1,0,0},
+    {0,0,0,0,1,0,-1,0,-1,1},
+    {0,0,0,0,0,1,0,-1,-1,0}
+  });
+}
 
 int main() {
   cout<<"testing matrix...";
@@ -115,4 +167,8 @@ int main() {
   cout<<"testing solve_over_Z2...";
   test_solve_over_Z2();
   cout<<"OK"<<endl;
+
+  cout<<"testing GF2Matrix...";
+  test_gf2_matrix();
+  cout<<"OK"<<endl;
 }
@@ -13,11 +13,32 @@ void test_permutations(const vector<int>& from, const vector<int>& to) {
   }
 }
 
+//the permutations visited with pruning are those of all_permutations satisfying the condition, in the same order
+void test_pruned_permutations(const vector<int>& from, const vector<int>& to) {
+  auto fixes_first_node=[] (const vector<int>& sigma) {return sigma[0]==0;};
+  auto all=PermutationsPreservingHash{from,to}.all_permutations();
+  all.remove_if([&fixes_first_node] (const vector<int>& sigma) {return !fixes_first_node(sigma);});
+  list<vector<int>> pruned;
+  PermutationsPreservingHash{from,to}.for_each_permutation(
+    [] (const vector<int>& sigma, int node) {return node>0 || sigma[0]==0;},
+    [&pruned] (const vector<int>& sigma) {pruned.push_back(sigma); return false;}
+  );
+  assert(pruned==all);
+  int visited=0;
+  bool stopped=PermutationsPreservingHash{from,to}.for_each_permutation(
+    [] (const vector<int>&, int) {return true;},
+    [&visited] (const vector<int>&) {return ++visited==2;}
+  );
+  assert(stopped && visited==2);
+}
+
 void test_permutations() {
   test_permutations({1,2,3},{1,2,3});
   test_permutations({1,1,1},{1,1,1});
   test_permutations({1,2,1},{2,1,1});
   test_permutations({1,2,3,2,3},{3,3,2,2,1});
+  test_pruned_permutations({1,1,1},{1,1,1});
+  test_pruned_permutations({2,1,2,1},{2,1,1,2});
 }
 
 int main() {
@@ -66,14 +66,56 @@ void test_inequalities() {
 	eqns = lst{ 2*a+2*b-1,-a-b};
 	LinearInequalities l3 {eqns.begin(),eqns.end(),StructureConstant{}};	
 	assert((!move(l3).has_solution()));
+	eqns = lst{ a/2+b/3-1,-a/2-b/3+ex{3}/2, a-b};
+	LinearInequalities l4 {eqns.begin(),eqns.end(),StructureConstant{}};
+	assert((move(l4).has_solution()));
+	//infeasible, since b>a+1 and b<2a+2 give a>-1, whereas 2a+b<-2 gives a<-1; duplicate combinations must not be merged when pruning by Chernikov's rule
+	eqns = lst{-2*a+2*b-2, -a+b, a+b+1, -2*a-2*b, -2*a+1, -2*a-b-2, 2*a-b+2};
+	LinearInequalities l5 {eqns.begin(),eqns.end(),StructureConstant{}};
+	assert((!move(l5).has_solution()));
 }
 
-int main() {
+//the configurations surviving the reduction by automorphisms, as computed by the original algorithm, which removed the images of each survivor from a list
+list<SignConfiguration> by_removal_from_list(const WeightMatrix& weight_matrix, const list<vector<int>>& nontrivial_automorphisms) {
+	SignConfigurations sign_configurations{weight_matrix,{}};
+	auto result=SignConfiguration::all_configurations(weight_matrix.rows()-weight_matrix.rank_over_Z2());
+	for (auto epsilon=result.begin();epsilon!=result.end();++epsilon)
+		for (auto& sigma : nontrivial_automorphisms) {
+			auto delta_sigma_epsilon=sign_configurations.delta(sigma,*epsilon);
+			if (delta_sigma_epsilon!=*epsilon) result.remove(delta_sigma_epsilon);
+		}
+	return result;
+}
+
+void test_sign_configurations(const LabeledTree& diagram) {
+	WeightMatrix weight_matrix{diagram.weights(),diagram.number_of_nodes()};
+	auto automorphisms=diagram.nontrivial_automorphisms();
+	auto expected=by_removal_from_list(weight_matrix,automorphisms);
+	assert(SignConfigurations(weight_matrix,automorphisms).sign_configurations()==expected);
+	if (weight_matrix.rank_over_Z2()==weight_matrix.rows()) assert(expected==list<SignConfiguration>{SignConfiguration{0}});
+}
+
+void test_sign_configurations(int dimension) {
+	for (auto& partition : partitions(dimension))
+		for (auto& diagram : nice_diagrams(partition,Filter{},DiagramDataOptions{}))
+			test_sign_configurations(diagram);
+}
+
+void test_inequalities_both_backends() {
+	test_inequalities();
+	LinearInequalities::set_exact_arithmetic(false);
 	test_inequalities();
+	LinearInequalities::set_exact_arithmetic(true);
+}
+
+int main() {
+	test_inequalities_both_backends();
 	test_signs(0);
 	test_signs(1);
 	test_signs(2);
 	test_signs(3);
+	test_sign_configurations(6);
+	test_sign_configurations(7);
 	test_tree({4,2,2},3004);
 	test_tree({4,3},82);
 	test_tree({2,1,1,1,1,1,1},484836536);
@@ -11,8 +11,84 @@
 #include "automorphisms.cpp"
 #include "dump.h"
 
+void test_canonical_certificate(const vector<int>& partition) {
+	for (auto& tree : trees(partition)) {
+		auto labelings=LabeledTree{tree}.labelings();
+		for (auto& labeled_tree : labelings) {
+			auto inverted=labeled_tree;
+			inverted.invert_nodes();
+			assert(inverted.canonical_certificate()==labeled_tree.canonical_certificate());
+			for (auto& other : labelings)
+				assert(other.is_equivalent_to(labeled_tree)==(other.canonical_certificate()==labeled_tree.canonical_certificate()));
+		}
+	}
+}
+
+void test_orderly_generation(const vector<int>& partition) {
+	EnumerationOptions orderly;
+	orderly.set(EnumerationOption::orderly_generation);
+	list<string> all_trees, trees_up_to_automorphisms;
+	for_each_tree(partition,[&all_trees] (const Tree& tree) {all_trees.push_back(tree.to_dot_string());});
+	for_each_tree(partition,[&trees_up_to_automorphisms] (const Tree& tree) {trees_up_to_automorphisms.push_back(tree.to_dot_string());},orderly);
+	assert(all_trees==trees_up_to_automorphisms);
+}
+
+//the automorphisms found by the canonical form must generate the whole automorphism group
+void test_automorphism_group_generators(const vector<int>& partition) {
+	for (auto& tree : trees(partition)) {
+		int n=tree.number_of_nodes();
+		vector<int> identity(n);
+		iota(identity.begin(),identity.end(),0);
+		set<vector<int>> group{identity};
+		list<vector<int>> elements{identity};
+		auto generators=tree.automorphism_group_generators();
+		for (auto& element : elements)
+			for (auto& sigma : generators) {
+				vector<int> product(n);
+				for (int i=0;i<n;++i) product[i]=sigma[element[i]];
+				if (group.insert(product).second) elements.push_back(move(product));
+			}
+		assert(group.size()==tree.nontrivial_automorphisms().size()+1);
+	}
+}
+
+void test_nice_labelings(const vector<int>& partition) {
+	for (auto& tree : trees(partition)) {
+		list<string> nice_labelings, filtered_labelings;
+		for (auto& labeled_tree : LabeledTree{tree}.nice_labelings()) nice_labelings.push_back(labeled_tree.to_dot_string());
+		for (auto& labeled_tree : LabeledTree{tree}.labelings())
+			if (satisfies_formal_jacobi(labeled_tree)) filtered_labelings.push_back(labeled_tree.to_dot_string());
+		assert(nice_labelings==filtered_labelings);
+	}
+}
+
+//the trees must not depend on whether incomplete trees are taken from the cache, recomputed, or evicted along the way
+void test_incomplete_trees_cache(const vector<int>& partition) {
+	auto certificates=[] (const list<Tree>& trees) {
+		list<pair<int,string>> result;
+		for (auto& tree : trees) result.push_back(tree.canonical_certificate());
+		return result;
+	};
+	auto cached=certificates(trees(partition));
+	set_incomplete_trees_cache_limit(0);
+	assert(certificates(trees(partition))==cached);
+	set_incomplete_trees_cache_limit(1);
+	assert(certificates(trees(partition))==cached);
+	set_incomplete_trees_cache_limit(1<<18);
+	assert(certificates(trees(partition))==cached);
+}
 
 int main() {
+    test_canonical_certificate({3,2,1});
+    test_canonical_certificate({2,2,1,1});
+    test_orderly_generation({2,2,1,1,1});
+    test_orderly_generation({3,2,2});
+    test_automorphism_group_generators({2,2,2,1,1});
+    test_automorphism_group_generators({3,2,1,1,1});
+    test_nice_labelings({3,2,1,1});
+    test_nice_labelings({2,2,2,1});
+    test_incomplete_trees_cache({3,2,1,1});
+    test_incomplete_trees_cache({2,2,1,1,1});
     dump("incomplete21",incomplete_trees({2,1},3));
     dump("complete221",trees({2,2,1}));
     dump("complete21111",trees({2,1,1,1,1}));